@@ -30,7 +30,7 @@ int8_t set_player_direction(const int8_t new_direction) {
   } else {  // if (new_direction == WEST)
     gpath_rotate_to(g_compass_path, TRIG_MAX_ANGLE / 4);
   }
-  layer_mark_dirty(window_get_root_layer(g_windows[GRAPHICS_WINDOW]));
+  layer_mark_dirty(g_scene_layer);
 
   return g_player->direction = new_direction;
 }
@@ -66,7 +66,7 @@ bool move_player(const int8_t direction) {
       g_player->position = destination;
     }
 
-    layer_mark_dirty(window_get_root_layer(g_windows[GRAPHICS_WINDOW]));
+    layer_mark_dirty(g_scene_layer);
 
     return true;
   }
@@ -88,10 +88,116 @@ void move_npc(npc_t *const npc, const int8_t direction) {
   GPoint destination = get_cell_farther_away(npc->position, direction, 1);
 
   if (occupiable(destination) && get_cell_type(destination) != EXIT) {
+    g_npc_grid[npc->position.x][npc->position.y] = NONE;
+    g_npc_grid[destination.x][destination.y] = npc - g_location->npcs;
     npc->position = destination;
   }
 }
 
+/*******************************************************************************
+   Function: remove_npc
+
+Description: Removes a given NPC from the current location, returning its slot
+             to the NPC pool's free list.
+
+     Inputs: npc - Pointer to the NPC to be removed.
+
+    Outputs: None.
+*******************************************************************************/
+void remove_npc(npc_t *const npc) {
+  int8_t last;
+  const int8_t i = npc - g_location->npcs;
+
+  if (npc->type == NONE) {
+    return;
+  }
+  g_npc_grid[npc->position.x][npc->position.y] = NONE;
+  npc->type = NONE;
+
+  // Move the last live NPC into the vacated spot in the active list:
+  last = g_location->active_npcs[--g_location->num_active_npcs];
+  g_location->active_npcs[g_location->npc_links[i]] = last;
+  g_location->npc_links[last] = g_location->npc_links[i];
+
+  // Then push the slot onto the free list:
+  g_location->npc_links[i] = g_location->first_free_npc;
+  g_location->first_free_npc = i;
+}
+
+/*******************************************************************************
+   Function: get_npc_status_effect
+
+Description: Returns the number of ticks remaining for one of a given NPC's
+             status effects. (Effects are stored as expiry ticks, so they wear
+             off without any per-tick bookkeeping. Only the low 16 bits are
+             kept, so an expiry tick more than MAX_STATUS_EFFECT_DURATION ahead
+             must lie in the past.)
+
+     Inputs: npc           - Pointer to the NPC of interest.
+             status_effect - Integer representing the status effect.
+
+    Outputs: Ticks remaining (zero if the effect isn't active).
+*******************************************************************************/
+uint8_t get_npc_status_effect(const npc_t *const npc,
+                              const int8_t status_effect) {
+  const uint16_t ticks_remaining =
+    (uint16_t) (npc->status_effect_expiry_ticks[status_effect] -
+                  (uint16_t) g_location->tick_count);
+
+  return ticks_remaining <= MAX_STATUS_EFFECT_DURATION ? ticks_remaining : 0;
+}
+
+/*******************************************************************************
+   Function: add_npc_status_effect
+
+Description: Extends one of a given NPC's status effects by a given number of
+             ticks (up to MAX_STATUS_EFFECT_DURATION in all).
+
+     Inputs: npc           - Pointer to the NPC of interest.
+             status_effect - Integer representing the status effect.
+             duration      - Number of ticks to be added.
+
+    Outputs: None.
+*******************************************************************************/
+void add_npc_status_effect(npc_t *const npc,
+                           const int8_t status_effect,
+                           const uint8_t duration) {
+  int16_t ticks_remaining = get_npc_status_effect(npc, status_effect) +
+                              duration;
+
+  if (ticks_remaining > MAX_STATUS_EFFECT_DURATION) {
+    ticks_remaining = MAX_STATUS_EFFECT_DURATION;
+  }
+  npc->status_effect_expiry_ticks[status_effect] =
+    (uint16_t) (g_location->tick_count + ticks_remaining);
+}
+
+/*******************************************************************************
+   Function: sweep_npc_status_effects
+
+Description: Resets the expiry ticks of live NPCs' expired status effects to
+             the current tick, so they can't appear to come back once the
+             16-bit tick count wraps around. (Called every
+             STATUS_EFFECT_SWEEP_INTERVAL ticks.)
+
+     Inputs: None.
+
+    Outputs: None.
+*******************************************************************************/
+void sweep_npc_status_effects(void) {
+  int8_t i, j;
+  npc_t *npc;
+
+  for (i = 0; i < g_location->num_active_npcs; ++i) {
+    npc = &g_location->npcs[g_location->active_npcs[i]];
+    for (j = 0; j < NUM_STATUS_EFFECTS; ++j) {
+      if (get_npc_status_effect(npc, j) == 0) {
+        npc->status_effect_expiry_ticks[j] = g_location->tick_count;
+      }
+    }
+  }
+}
+
 /*******************************************************************************
    Function: damage_player
 
@@ -135,7 +241,7 @@ int8_t damage_npc(npc_t *const npc, int8_t damage) {
   npc->health -= damage;
 
   // Check for NPC death:
-  if (npc->health <= 0 || npc->status_effects[DISINTEGRATION]) {
+  if (npc->health <= 0 || get_npc_status_effect(npc, DISINTEGRATION)) {
     // Drop loot, if any (extra checks prevent overwriting of Pebbles/exits):
     if (npc->type == MAGE ||
         (npc->item > NONE && get_cell_type(npc->position) < EXIT)) {
@@ -145,13 +251,13 @@ int8_t damage_npc(npc_t *const npc, int8_t damage) {
     // Check for "game completion" (death of the final mage):
     if (g_player->int8_stats[DEPTH] == MAX_DEPTH && npc->type == MAGE) {
       show_narration(ENDING_NARRATION);
-      npc->type = NONE;
+      remove_npc(npc);
 
       return damage;
     }
 
-    // Remove the NPC by merely changing its type:
-    npc->type = NONE;
+    // Remove the NPC (its slot is then free for reuse):
+    remove_npc(npc);
 
     // Add experience points and check for a "level up":
     if (g_player->int8_stats[LEVEL] < MAX_LEVEL) {
@@ -199,7 +305,7 @@ int8_t cast_spell_on_npc(npc_t *const npc,
 
     // Next, attempt to apply a status effect:
     if (magic_type < PEBBLE_OF_DEATH || potency > spell_resistance) {
-      npc->status_effects[magic_type] += potency;
+      add_npc_status_effect(npc, magic_type, potency);
     }
 
     // Finally, apply damage and check for health absorption:
@@ -267,18 +373,14 @@ Description: Initializes a new NPC of a given type at a given position (unless
     Outputs: "True" if a new NPC is successfully added.
 *******************************************************************************/
 bool add_new_npc(const int8_t npc_type, const GPoint position) {
-  int8_t i;
   npc_t *npc;
 
-  if (occupiable(position) && get_cell_type(position) != EXIT) {
-    for (i = 0; i < MAX_NPCS_AT_ONE_TIME; ++i) {
-      npc = &g_location->npcs[i];
-      if (npc->type == NONE) {
-        init_npc(npc, npc_type, position);
+  if (occupiable(position) &&
+      get_cell_type(position) != EXIT &&
+      (npc = allocate_npc()) != NULL) {
+    init_npc(npc, npc_type, position);
 
-        return true;
-      }
-    }
+    return true;
   }
 
   return false;
@@ -301,150 +403,103 @@ Description: Given a set of cell coordinates, returns new cell coordinates a
 GPoint get_cell_farther_away(const GPoint reference_point,
                              const int8_t direction,
                              const int8_t distance) {
-  switch (direction) {
-    case NORTH:
-      return GPoint(reference_point.x, reference_point.y - distance);
-    case SOUTH:
-      return GPoint(reference_point.x, reference_point.y + distance);
-    case EAST:
-      return GPoint(reference_point.x + distance, reference_point.y);
-    default:  // case WEST:
-      return GPoint(reference_point.x - distance, reference_point.y);
-  }
+  const GPoint vector = g_direction_vectors[direction];
+
+  return GPoint(reference_point.x + vector.x * distance,
+                reference_point.y + vector.y * distance);
 }
 
 /*******************************************************************************
-   Function: get_pursuit_direction
+   Function: update_distance_field
 
-Description: Determines in which direction a character at a given position ought
-             to move in order to pursue a character at another given position.
-             (Simplistic: no complex path-finding.)
+Description: Recomputes "g_distance_field" (the number of steps from the player
+             to each cell, via a breadth-first search) if the player has moved
+             or the map has changed since it was last computed. NPCs are
+             ignored, since they move every tick.
 
-     Inputs: pursuer - Position of the pursuing character.
-             pursuee - Position of the character being pursued.
+     Inputs: None.
 
-    Outputs: Integer representing the direction in which the NPC ought to move.
+    Outputs: None.
 *******************************************************************************/
-int8_t get_pursuit_direction(const GPoint pursuer, const GPoint pursuee) {
-  int8_t diff_x = pursuer.x - pursuee.x,
-         diff_y = pursuer.y - pursuee.y;
-  const int8_t horizontal_direction = diff_x > 0 ? WEST : EAST,
-               vertical_direction = diff_y > 0 ? NORTH : SOUTH;
-  bool checked_horizontal_direction = false,
-       checked_vertical_direction = false;
-
-  // Check for alignment along the x-axis:
-  if (diff_x == 0) {
-    if (diff_y == 1 /* The two are already touching. */ ||
-        occupiable(get_cell_farther_away(pursuer,
-                                         vertical_direction,
-                                         1))) {
-      return vertical_direction;
-    }
-    checked_vertical_direction = true;
+void update_distance_field(void) {
+  int8_t i;
+  uint8_t open_neighbors;
+  int16_t head = 0, tail = 0;
+  GPoint cell, neighbor;
 
-  // Check for alignment along the y-axis:
-  } else if (diff_y == 0) {
-    if (diff_x == 1 /* The two are already touching. */ ||
-        occupiable(get_cell_farther_away(pursuer,
-                                         horizontal_direction,
-                                         1))) {
-      return horizontal_direction;
-    }
-    checked_horizontal_direction = true;
+  if (g_distance_field_is_current &&
+      gpoint_equal(&g_distance_field_origin, &g_player->position)) {
+    return;
+  }
+  memset(g_distance_field, NONE, sizeof(g_distance_field));
+  g_distance_field_origin = g_player->position;
+  g_distance_field_is_current = true;
+  if (is_solid(g_player->position)) {
+    return;  // The player isn't on the map (e.g., during a benchmark).
   }
 
-  // If not aligned along either axis, a direction in either axis will do:
-  while (!checked_horizontal_direction || !checked_vertical_direction) {
-    if (checked_vertical_direction ||
-        (!checked_horizontal_direction && rand() % 2)) {
-      if (occupiable(get_cell_farther_away(pursuer,
-                                           horizontal_direction,
-                                           1))) {
-        return horizontal_direction;
+  g_distance_field[g_player->position.x][g_player->position.y] = 0;
+  g_distance_field_queue[tail++] = g_player->position.y * MAP_WIDTH +
+                                     g_player->position.x;
+  while (head < tail) {
+    cell = GPoint(g_distance_field_queue[head] % MAP_WIDTH,
+                  g_distance_field_queue[head] / MAP_WIDTH);
+    head++;
+    open_neighbors = get_open_neighbors(cell);
+    for (i = 0; i < NUM_DIRECTIONS; ++i) {
+      if (!(open_neighbors >> i & 1)) {
+        continue;
       }
-      checked_horizontal_direction = true;
-    }
-    if (!checked_vertical_direction) {
-      if (occupiable(get_cell_farther_away(pursuer,
-                                           vertical_direction,
-                                           1))) {
-        return vertical_direction;
+      neighbor = get_cell_farther_away(cell, i, 1);
+      if (get_cell_type(neighbor) != EXIT &&  // NPCs can't enter exits.
+          g_distance_field[neighbor.x][neighbor.y] == NONE) {
+        g_distance_field[neighbor.x][neighbor.y] =
+          g_distance_field[cell.x][cell.y] + 1;
+        g_distance_field_queue[tail++] = neighbor.y * MAP_WIDTH + neighbor.x;
       }
-      checked_vertical_direction = true;
     }
   }
-
-  // If we reach this point, the NPC is stuck in a corner. I'm okay with that:
-  return horizontal_direction;
 }
 
 /*******************************************************************************
-   Function: get_direction_to_the_left
+   Function: get_distance_field_direction
 
-Description: Given a north/south/east/west reference direction, returns the
-             direction to its left.
+Description: Determines in which direction an NPC at a given position ought to
+             move in order to get as much closer to (or farther from) the
+             player as possible, according to "g_distance_field".
 
-     Inputs: reference_direction - Direction from which to turn left.
+     Inputs: position - Position of the NPC.
+             fleeing  - "True" if the NPC is moving away from the player.
 
-    Outputs: Integer representing the direction to the left of the reference
-             direction.
+    Outputs: Integer representing the direction in which the NPC ought to move,
+             or NONE if no unoccupied neighboring cell is an improvement.
 *******************************************************************************/
-int8_t get_direction_to_the_left(const int8_t reference_direction) {
-  if (reference_direction == NORTH) {
-    return WEST;
-  } else if (reference_direction == WEST) {
-    return SOUTH;
-  } else if (reference_direction == SOUTH) {
-    return EAST;
-  } else {  // if (reference_direction == EAST)
-    return NORTH;
+int8_t get_distance_field_direction(const GPoint position, const bool fleeing) {
+  int8_t i, direction = NONE;
+  uint8_t occupiable_neighbors;
+  int16_t distance, best_distance;
+  GPoint neighbor;
+
+  update_distance_field();
+  best_distance = g_distance_field[position.x][position.y];
+  if (best_distance == NONE) {
+    return NONE;  // The player is unreachable.
   }
-}
-
-/*******************************************************************************
-   Function: get_direction_to_the_right
-
-Description: Given a north/south/east/west reference direction, returns the
-             direction to its right.
-
-     Inputs: reference_direction - Direction from which to turn right.
-
-    Outputs: Integer representing the direction to the right of the reference
-             direction.
-*******************************************************************************/
-int8_t get_direction_to_the_right(const int8_t reference_direction) {
-  if (reference_direction == NORTH) {
-    return EAST;
-  } else if (reference_direction == EAST) {
-    return SOUTH;
-  } else if (reference_direction == SOUTH) {
-    return WEST;
-  } else {  // if (reference_direction == WEST)
-    return NORTH;
+  occupiable_neighbors = get_occupiable_neighbors(position);
+  for (i = 0; i < NUM_DIRECTIONS; ++i) {
+    if (!(occupiable_neighbors >> i & 1)) {
+      continue;
+    }
+    neighbor = get_cell_farther_away(position, i, 1);
+    distance = g_distance_field[neighbor.x][neighbor.y];
+    if (distance != NONE &&
+        (fleeing ? distance > best_distance : distance < best_distance)) {
+      best_distance = distance;
+      direction = i;
+    }
   }
-}
-
-/*******************************************************************************
-   Function: get_opposite_direction
-
-Description: Returns the opposite of a given direction value (i.e., given the
-             argument "NORTH", "SOUTH" will be returned).
-
-     Inputs: direction - The direction whose opposite is desired.
 
-    Outputs: Integer representing the opposite of the given direction.
-*******************************************************************************/
-int8_t get_opposite_direction(const int8_t direction) {
-  if (direction == NORTH) {
-    return SOUTH;
-  } else if (direction == SOUTH) {
-    return NORTH;
-  } else if (direction == EAST) {
-    return WEST;
-  } else {  // if (direction == WEST)
-    return EAST;
-  }
+  return direction;
 }
 
 /*******************************************************************************
@@ -547,38 +602,334 @@ heavy_item_t *get_heavy_item_equipped_at(const int8_t equip_target) {
 }
 
 /*******************************************************************************
-   Function: get_cell_type
+   Function: get_terrain
 
-Description: Returns the type of cell at a given set of coordinates.
+Description: Returns the two-bit terrain code stored for a given cell of a given
+             location. (Doesn't test coordinates to ensure they're in-bounds!)
 
-     Inputs: cell - Coordinates of the cell of interest.
+     Inputs: location - Pointer to the location of interest.
+             cell     - Coordinates of the cell of interest.
+
+    Outputs: The indicated cell's terrain code.
+*******************************************************************************/
+int8_t get_terrain(const location_t *const location, const GPoint cell) {
+  const int16_t i = cell.y * MAP_WIDTH + cell.x;
+
+  return (location->terrain[i / TERRAIN_CELLS_PER_BYTE] >>
+            (i % TERRAIN_CELLS_PER_BYTE * TERRAIN_BITS_PER_CELL)) &
+         TERRAIN_MASK;
+}
+
+/*******************************************************************************
+   Function: set_terrain
+
+Description: Sets the two-bit terrain code stored for a given cell of a given
+             location. (Doesn't test coordinates to ensure they're in-bounds!)
+
+     Inputs: location - Pointer to the location of interest.
+             cell     - Coordinates of the cell of interest.
+             terrain  - The terrain code to be assigned to that cell.
+
+    Outputs: None.
+*******************************************************************************/
+void set_terrain(location_t *const location,
+                 const GPoint cell,
+                 const int8_t terrain) {
+  const int16_t i = cell.y * MAP_WIDTH + cell.x;
+  const int8_t shift = i % TERRAIN_CELLS_PER_BYTE * TERRAIN_BITS_PER_CELL;
+  uint8_t *const byte = &location->terrain[i / TERRAIN_CELLS_PER_BYTE];
+
+  *byte = (*byte & ~(TERRAIN_MASK << shift)) | (terrain << shift);
+}
+
+/*******************************************************************************
+   Function: find_special_cell_slot
+
+Description: Binary-searches a given location's side table of exits and loot
+             (sorted by SPECIAL_CELL_INDEX) for the slot where a given cell's
+             entry is, or would be inserted.
+
+     Inputs: location - Pointer to the location of interest.
+             cell     - Coordinates of the cell of interest.
+
+    Outputs: Index value for "location->special_cells" (up to
+             "location->num_special_cells").
+*******************************************************************************/
+int16_t find_special_cell_slot(const location_t *const location,
+                               const GPoint cell) {
+  int16_t low = 0, high = location->num_special_cells, middle;
+  const int16_t cell_index = SPECIAL_CELL_INDEX(cell);
+
+  while (low < high) {
+    middle = (low + high) / 2;
+    if (SPECIAL_CELL_INDEX(location->special_cells[middle]) < cell_index) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+
+  return low;
+}
+
+/*******************************************************************************
+   Function: find_special_cell
+
+Description: Searches a given location's side table of exits and loot for a
+             given cell.
+
+     Inputs: location - Pointer to the location of interest.
+             cell     - Coordinates of the cell of interest.
+
+    Outputs: Index value for "location->special_cells" (NONE if not found).
+*******************************************************************************/
+int16_t find_special_cell(const location_t *const location,
+                          const GPoint cell) {
+  const int16_t i = find_special_cell_slot(location, cell);
+
+  if (i < location->num_special_cells &&
+      location->special_cells[i].x == cell.x &&
+      location->special_cells[i].y == cell.y) {
+    return i;
+  }
+
+  return NONE;
+}
+
+/*******************************************************************************
+   Function: get_location_cell_type
+
+Description: Returns the type of cell at a given set of coordinates of a given
+             location.
+
+     Inputs: location - Pointer to the location of interest.
+             cell     - Coordinates of the cell of interest.
 
     Outputs: The indicated cell's type.
 *******************************************************************************/
-int8_t get_cell_type(const GPoint cell) {
+int8_t get_location_cell_type(const location_t *const location,
+                              const GPoint cell) {
+  int8_t terrain;
+  int16_t i;
+
   if (cell.x < 0 ||
       cell.x >= MAP_WIDTH ||
       cell.y < 0 ||
       cell.y >= MAP_HEIGHT) {
     return SOLID;
   }
+  terrain = get_terrain(location, cell);
+  if (terrain == SPECIAL_TERRAIN) {
+    i = find_special_cell(location, cell);
 
-  return g_location->map[cell.x][cell.y];
+    return i == NONE ? EMPTY : location->special_cells[i].type;
+  }
+
+  return terrain == SOLID_TERRAIN ? SOLID : EMPTY;
+}
+
+/*******************************************************************************
+   Function: get_cell_type
+
+Description: Returns the type of cell at a given set of coordinates of the
+             current location.
+
+     Inputs: cell - Coordinates of the cell of interest.
+
+    Outputs: The indicated cell's type.
+*******************************************************************************/
+int8_t get_cell_type(const GPoint cell) {
+  return get_location_cell_type(g_location, cell);
+}
+
+/*******************************************************************************
+   Function: is_solid
+
+Description: Determines whether the cell at a given set of coordinates is solid
+             (out-of-bounds cells count as solid), via the "g_solid_cells"
+             bitboard rather than the location's map.
+
+     Inputs: cell - Coordinates of the cell of interest.
+
+    Outputs: "True" if the cell is solid.
+*******************************************************************************/
+bool is_solid(const GPoint cell) {
+  // Anything beyond the bitboard's sentinel border is solid, too:
+  if ((uint16_t) (cell.x + 1) > MAP_WIDTH + 1 ||
+      (uint16_t) (cell.y + 1) > MAP_HEIGHT + 1) {
+    return true;
+  }
+
+  return (g_solid_cells[SOLID_CELL_BIT_INDEX(cell) / 32] >>
+            (SOLID_CELL_BIT_INDEX(cell) % 32)) &
+         1;
+}
+
+/*******************************************************************************
+   Function: get_solid_cell_span
+
+Description: Determines which of a run of consecutive cells along a row (or
+             column) are solid, reading the run from the relevant bitboard a
+             pair of words at a time rather than cell by cell. Out-of-bounds
+             cells count as solid.
+
+     Inputs: first    - Coordinates of the run's westernmost (or northernmost)
+                        cell.
+             vertical - "True" if the run is along a column (running south),
+                        "false" if along a row (running east).
+             length   - Number of cells in the run (up to MAX_SOLID_CELL_SPAN).
+
+    Outputs: A mask with bit "i" set if the run's "i"th cell is solid.
+*******************************************************************************/
+uint32_t get_solid_cell_span(const GPoint first,
+                             const bool vertical,
+                             const int8_t length) {
+  int16_t start = vertical ? first.y : first.x, num_skipped = 0, num_read,
+          bit_index;
+  uint32_t read_mask;
+  uint64_t words;
+  const uint32_t *const bitboard = vertical ? g_solid_cell_columns :
+                                              g_solid_cells;
+  const int16_t line = vertical ? first.x : first.y,
+                num_lines = vertical ? MAP_WIDTH : MAP_HEIGHT,
+                line_length = vertical ? MAP_HEIGHT : MAP_WIDTH;
+  const uint32_t all_solid = ((uint32_t) 1 << length) - 1;
+
+  // Rows (or columns) beyond the border are entirely solid:
+  if (line < -1 || line > num_lines) {
+    return all_solid;
+  }
+
+  // So are cells beyond either end of the border:
+  if (start < -1) {
+    num_skipped = -1 - start;
+    start = -1;
+  }
+  num_read = line_length + 1 - start;  // Cells left, including the border.
+  if (num_read > length - num_skipped) {
+    num_read = length - num_skipped;
+  }
+  if (num_read <= 0) {
+    return all_solid;
+  }
+
+  // Read the rest with a single shift:
+  bit_index = (line + 1) * (line_length + 2) + start + 1;
+  words = bitboard[bit_index / 32] |
+          (uint64_t) bitboard[bit_index / 32 + 1] << 32;
+  read_mask = (((uint32_t) 1 << num_read) - 1) << num_skipped;
+
+  return (all_solid & ~read_mask) |
+         ((uint32_t) (words >> (bit_index % 32)) << num_skipped & read_mask);
+}
+
+/*******************************************************************************
+   Function: get_open_neighbors
+
+Description: Determines which of a given cell's four neighbors are non-solid,
+             via one three-cell span of its row and one of its column.
+
+     Inputs: cell - Coordinates of the cell of interest.
+
+    Outputs: A mask with bit "direction" set for each non-solid neighbor.
+*******************************************************************************/
+uint8_t get_open_neighbors(const GPoint cell) {
+  const uint32_t row = ~get_solid_cell_span(GPoint(cell.x - 1, cell.y),
+                                            false,
+                                            3),
+                 column = ~get_solid_cell_span(GPoint(cell.x, cell.y - 1),
+                                               true,
+                                               3);
+
+  return (column & 1) << NORTH |
+         (column >> 2 & 1) << SOUTH |
+         (row >> 2 & 1) << EAST |
+         (row & 1) << WEST;
+}
+
+/*******************************************************************************
+   Function: set_location_cell_type
+
+Description: Sets the cell at a given set of coordinates of a given location to
+             a given type, leaving the current location's caches alone (see
+             "set_cell_type"). Exits and loot are kept in a side table, whose
+             last free entry is kept for the exit, so loot that doesn't fit
+             leaves the cell EMPTY. (Doesn't test coordinates to ensure they're
+             in-bounds!)
+
+     Inputs: location - Pointer to the location of interest.
+             cell     - Coordinates of the cell of interest.
+             type     - The cell type to be assigned at those coordinates.
+
+    Outputs: "False" if the side table had no room for the cell.
+*******************************************************************************/
+bool set_location_cell_type(location_t *const location,
+                            const GPoint cell,
+                            const int8_t type) {
+  int16_t i = NONE;
+  special_cell_t *const special_cells = location->special_cells;
+
+  if (get_terrain(location, cell) == SPECIAL_TERRAIN) {
+    i = find_special_cell(location, cell);
+  }
+  if (type >= EXIT) {
+    if (i == NONE &&
+        location->num_special_cells <
+          MAX_SPECIAL_CELLS - (type == EXIT ? 0 : 1)) {
+      i = find_special_cell_slot(location, cell);
+      memmove(&special_cells[i + 1],
+              &special_cells[i],
+              (location->num_special_cells++ - i) * sizeof(special_cell_t));
+      special_cells[i].x = cell.x;
+      special_cells[i].y = cell.y;
+    }
+    if (i == NONE) {
+      set_terrain(location, cell, EMPTY_TERRAIN);
+
+      return false;
+    }
+    special_cells[i].type = type;
+    set_terrain(location, cell, SPECIAL_TERRAIN);
+  } else {
+    if (i > NONE) {
+      memmove(&special_cells[i],
+              &special_cells[i + 1],
+              (--location->num_special_cells - i) * sizeof(special_cell_t));
+    }
+    set_terrain(location, cell, type == SOLID ? SOLID_TERRAIN : EMPTY_TERRAIN);
+  }
+
+  return true;
 }
 
 /*******************************************************************************
    Function: set_cell_type
 
-Description: Sets the cell at a given set of coordinates to a given type.
-             (Doesn't test coordinates to ensure they're in-bounds!)
+Description: Sets the cell at a given set of coordinates of the current
+             location to a given type (see "set_location_cell_type"), keeping
+             the caches derived from its map up to date. (Doesn't test
+             coordinates to ensure they're in-bounds!)
 
      Inputs: cell - Coordinates of the cell of interest.
              type - The cell type to be assigned at those coordinates.
 
-    Outputs: None.
+    Outputs: "False" if the side table of exits and loot had no room for the
+             cell (which is left EMPTY).
 *******************************************************************************/
-void set_cell_type(GPoint cell, const int8_t type) {
-  g_location->map[cell.x][cell.y] = type;
+bool set_cell_type(GPoint cell, const int8_t type) {
+  const bool was_solid = is_solid(cell),
+             fits = set_location_cell_type(g_location, cell, type);
+
+  g_distance_field_is_current = false;
+  if (was_solid != (type == SOLID)) {
+    g_solid_cells[SOLID_CELL_BIT_INDEX(cell) / 32] ^=
+      (uint32_t) 1 << (SOLID_CELL_BIT_INDEX(cell) % 32);
+    g_solid_cell_columns[SOLID_CELL_COLUMN_BIT_INDEX(cell) / 32] ^=
+      (uint32_t) 1 << (SOLID_CELL_COLUMN_BIT_INDEX(cell) % 32);
+    update_line_of_sight_runs(cell);
+  }
+
+  return fits;
 }
 
 /*******************************************************************************
@@ -591,17 +942,95 @@ Description: Returns a pointer to the NPC occupying a given cell.
     Outputs: Pointer to the NPC occupying thecell, or NULL if there is none.
 *******************************************************************************/
 npc_t *get_npc_at(const GPoint cell) {
+  if (cell.x < 0 ||
+      cell.x >= MAP_WIDTH ||
+      cell.y < 0 ||
+      cell.y >= MAP_HEIGHT ||
+      g_npc_grid[cell.x][cell.y] == NONE) {
+    return NULL;
+  }
+
+  return &g_location->npcs[g_npc_grid[cell.x][cell.y]];
+}
+
+/*******************************************************************************
+   Function: link_npc_pool
+
+Description: Rebuilds a given location's NPC pool's active and free lists from
+             the types of its NPCs, leaving the current location's NPC
+             occupancy grid alone (see "init_npc_pool").
+
+     Inputs: location - Pointer to the location of interest.
+
+    Outputs: None.
+*******************************************************************************/
+void link_npc_pool(location_t *const location) {
   int8_t i;
-  npc_t *npc;
 
+  location->num_active_npcs = 0;
   for (i = 0; i < MAX_NPCS_AT_ONE_TIME; ++i) {
-    npc = &g_location->npcs[i];
-    if (npc->type > NONE && gpoint_equal(&npc->position, &cell)) {
-      return npc;
+    if (location->npcs[i].type > NONE) {
+      location->npc_links[i] = location->num_active_npcs;
+      location->active_npcs[location->num_active_npcs++] = i;
     }
   }
 
-  return NULL;
+  // Free slots are linked in ascending order:
+  location->first_free_npc = NONE;
+  for (i = MAX_NPCS_AT_ONE_TIME - 1; i >= 0; --i) {
+    if (location->npcs[i].type == NONE) {
+      location->npc_links[i] = location->first_free_npc;
+      location->first_free_npc = i;
+    }
+  }
+}
+
+/*******************************************************************************
+   Function: init_npc_pool
+
+Description: Rebuilds the current location's NPC pool's active and free lists,
+             and the NPC occupancy grid, from the types of the NPCs in
+             "g_location->npcs" (e.g., after the current location has been
+             loaded, reset, or replaced wholesale).
+
+     Inputs: None.
+
+    Outputs: None.
+*******************************************************************************/
+void init_npc_pool(void) {
+  int8_t i;
+  npc_t *npc;
+
+  link_npc_pool(g_location);
+  memset(g_npc_grid, NONE, sizeof(g_npc_grid));
+  for (i = 0; i < g_location->num_active_npcs; ++i) {
+    npc = &g_location->npcs[g_location->active_npcs[i]];
+    g_npc_grid[npc->position.x][npc->position.y] = g_location->active_npcs[i];
+  }
+}
+
+/*******************************************************************************
+   Function: allocate_npc
+
+Description: Takes a slot from the NPC pool's free list and adds it to the
+             active list. The caller is expected to initialize the NPC (see
+             "init_npc").
+
+     Inputs: None.
+
+    Outputs: Pointer to the allocated NPC, or NULL if the pool is full.
+*******************************************************************************/
+npc_t *allocate_npc(void) {
+  const int8_t i = g_location->first_free_npc;
+
+  if (i == NONE) {
+    return NULL;
+  }
+  g_location->first_free_npc = g_location->npc_links[i];
+  g_location->npc_links[i] = g_location->num_active_npcs;
+  g_location->active_npcs[g_location->num_active_npcs++] = i;
+
+  return &g_location->npcs[i];
 }
 
 /*******************************************************************************
@@ -648,28 +1077,207 @@ char *get_stat_title_str(const int8_t stat_index) {
 }
 
 /*******************************************************************************
-   Function: occupiable
+   Function: update_line_of_sight_runs
 
-Description: Determines whether the cell at a given set of coordinates may be
-             occupied by a game character (i.e., it's within map boundaries,
-             non-solid, not already occupied by another character, etc.).
+Description: Recomputes the horizontal runs of the row, and the vertical runs of
+             the column, passing through a given cell (see "g_horizontal_runs"
+             and "g_vertical_runs").
 
-     Inputs: cell - Coordinates of the cell of interest.
+     Inputs: cell - Coordinates of the cell whose row and column are to be
+                    updated.
 
-    Outputs: "True" if the cell is occupiable.
+    Outputs: None.
 *******************************************************************************/
-bool occupiable(const GPoint cell) {
-  return get_cell_type(cell) >= EMPTY &&
-         !gpoint_equal(&g_player->position, &cell) &&
-         get_npc_at(cell) == NULL;
+void update_line_of_sight_runs(const GPoint cell) {
+  int8_t i, run_start = 0;
+
+  for (i = 0; i < MAP_WIDTH; ++i) {
+    if (is_solid(GPoint(i, cell.y))) {
+      g_horizontal_runs[i][cell.y] = NONE;
+      run_start = i + 1;
+    } else {
+      g_horizontal_runs[i][cell.y] = run_start;
+    }
+  }
+  run_start = 0;
+  for (i = 0; i < MAP_HEIGHT; ++i) {
+    if (is_solid(GPoint(cell.x, i))) {
+      g_vertical_runs[cell.x][i] = NONE;
+      run_start = i + 1;
+    } else {
+      g_vertical_runs[cell.x][i] = run_start;
+    }
+  }
 }
 
 /*******************************************************************************
-   Function: show_narration
+   Function: init_map_caches
 
-Description: Displays desired narration text via the narration window.
+Description: Rebuilds everything derived from the current location's map (the
+             solid-cell bitboards and line-of-sight runs) from scratch, and
+             marks the distance field out of date (e.g., after the location has
+             been loaded or replaced wholesale).
 
-     Inputs: narration - Integer indicating desired narration text.
+     Inputs: None.
+
+    Outputs: None.
+*******************************************************************************/
+void init_map_caches(void) {
+  int8_t i, j;
+  GPoint cell;
+
+  // The bitboards' border rows and columns are permanently solid:
+  memset(g_solid_cells, 0xff, sizeof(g_solid_cells));
+  memset(g_solid_cell_columns, 0xff, sizeof(g_solid_cell_columns));
+  for (i = 0; i < MAP_WIDTH; ++i) {
+    for (j = 0; j < MAP_HEIGHT; ++j) {
+      cell = GPoint(i, j);
+      if (get_terrain(g_location, cell) != SOLID_TERRAIN) {
+        g_solid_cells[SOLID_CELL_BIT_INDEX(cell) / 32] &=
+          ~((uint32_t) 1 << (SOLID_CELL_BIT_INDEX(cell) % 32));
+        g_solid_cell_columns[SOLID_CELL_COLUMN_BIT_INDEX(cell) / 32] &=
+          ~((uint32_t) 1 << (SOLID_CELL_COLUMN_BIT_INDEX(cell) % 32));
+      }
+    }
+  }
+  for (i = 0; i < MAP_WIDTH; ++i) {
+    update_line_of_sight_runs(GPoint(i, 0));
+  }
+  for (i = 0; i < MAP_HEIGHT; ++i) {
+    update_line_of_sight_runs(GPoint(0, i));
+  }
+  g_distance_field_is_current = false;
+}
+
+/*******************************************************************************
+   Function: clear_location_map
+
+Description: Sets every cell of a given location to SOLID, with no exits or
+             loot, leaving the current location's caches alone (see
+             "clear_map").
+
+     Inputs: location - Pointer to the location of interest.
+
+    Outputs: None.
+*******************************************************************************/
+void clear_location_map(location_t *const location) {
+  memset(location->terrain, 0, sizeof(location->terrain));  // SOLID_TERRAIN
+  location->num_special_cells = 0;
+}
+
+/*******************************************************************************
+   Function: clear_map
+
+Description: Sets every cell of the current location to SOLID, with no exits or
+             loot.
+
+     Inputs: None.
+
+    Outputs: None.
+*******************************************************************************/
+void clear_map(void) {
+  clear_location_map(g_location);
+  init_map_caches();
+}
+
+/*******************************************************************************
+   Function: in_line_of_sight
+
+Description: Determines whether a given cell can be "seen" from another along
+             the x- or y-axis: the two must be within visibility range, in the
+             same run of non-solid cells, and have no NPCs between them.
+
+     Inputs: viewer - Coordinates of the viewing cell (must be in-bounds).
+             target - Coordinates of the cell being viewed (ditto).
+
+    Outputs: "True" if the target cell is visible from the viewing cell.
+*******************************************************************************/
+bool in_line_of_sight(const GPoint viewer, const GPoint target) {
+  int8_t i, direction;
+  const int8_t diff_x = target.x - viewer.x,
+               diff_y = target.y - viewer.y,
+               distance = abs(diff_x + diff_y);
+
+  if ((diff_x != 0 && diff_y != 0) ||
+      distance > MAX_VISIBILITY_DEPTH - 2) {
+    return false;
+  }
+  if (diff_y == 0) {
+    if (g_horizontal_runs[viewer.x][viewer.y] !=
+          g_horizontal_runs[target.x][target.y]) {
+      return false;
+    }
+    direction = diff_x > 0 ? EAST : WEST;
+  } else {
+    if (g_vertical_runs[viewer.x][viewer.y] !=
+          g_vertical_runs[target.x][target.y]) {
+      return false;
+    }
+    direction = diff_y > 0 ? SOUTH : NORTH;
+  }
+
+  // Check for intervening NPCs (at most a few occupancy grid lookups):
+  for (i = 1; i < distance; ++i) {
+    if (get_npc_at(get_cell_farther_away(viewer, direction, i))) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/*******************************************************************************
+   Function: occupiable
+
+Description: Determines whether the cell at a given set of coordinates may be
+             occupied by a game character (i.e., it's within map boundaries,
+             non-solid, not already occupied by another character, etc.).
+
+     Inputs: cell - Coordinates of the cell of interest.
+
+    Outputs: "True" if the cell is occupiable.
+*******************************************************************************/
+bool occupiable(const GPoint cell) {
+  return !is_solid(cell) &&
+         !gpoint_equal(&g_player->position, &cell) &&
+         get_npc_at(cell) == NULL;
+}
+
+/*******************************************************************************
+   Function: get_occupiable_neighbors
+
+Description: Determines which of a given cell's four neighbors are occupiable
+             (see "occupiable"), starting from the mask of non-solid neighbors
+             so that only those need checking for characters.
+
+     Inputs: cell - Coordinates of the cell of interest.
+
+    Outputs: A mask with bit "direction" set for each occupiable neighbor.
+*******************************************************************************/
+uint8_t get_occupiable_neighbors(const GPoint cell) {
+  int8_t i;
+  uint8_t neighbors = get_open_neighbors(cell);
+  GPoint neighbor;
+
+  for (i = 0; i < NUM_DIRECTIONS; ++i) {
+    if (neighbors >> i & 1) {
+      neighbor = get_cell_farther_away(cell, i, 1);
+      if (gpoint_equal(&g_player->position, &neighbor) ||
+          get_npc_at(neighbor) != NULL) {
+        neighbors &= ~(1 << i);
+      }
+    }
+  }
+
+  return neighbors;
+}
+
+/*******************************************************************************
+   Function: show_narration
+
+Description: Displays desired narration text via the narration window.
+
+     Inputs: narration - Integer indicating desired narration text.
 
     Outputs: Integer representing the narration text shown.
 *******************************************************************************/
@@ -1067,6 +1675,7 @@ void menu_select_callback(MenuLayer *menu_layer,
   bool item_was_equipped = false;
   heavy_item_t *heavy_item;
 
+  schedule_idle_work();
   if (menu_layer == g_menu_layers[MAIN_MENU]) {
     if (cell_index->row == 0) {  // Play
       show_window(GRAPHICS_WINDOW, NOT_ANIMATED);
@@ -1250,11 +1859,91 @@ static uint16_t menu_get_num_rows_callback(MenuLayer *menu_layer,
   }
 }
 
+/*******************************************************************************
+   Function: get_scene_hash
+
+Description: Computes a compact hash of everything "draw_scene" reads: the
+             player's direction, the floor and wall color schemes, and the
+             type, NPC, and entrance status of every cell in (or bordering) the
+             view cone. Two scenes with the same hash look the same.
+
+     Inputs: None.
+
+    Outputs: The scene hash.
+*******************************************************************************/
+uint32_t get_scene_hash(void) {
+  int8_t depth, offset;
+  uint32_t hash = SCENE_HASH_OFFSET_BASIS;
+  GPoint cell;
+  npc_t *npc;
+  const GPoint forward = g_direction_vectors[g_player->direction],
+               rightward = g_direction_vectors[g_directions_to_the_right
+                                                 [g_player->direction]];
+
+  hash = HASH_COMBINE(hash, g_player->direction);
+  hash = HASH_COMBINE(hash, g_location->floor_color_scheme);
+  hash = HASH_COMBINE(hash, g_location->wall_color_scheme);
+
+  // Walls depend on neighbors, so go one cell beyond the cone in every way:
+  for (depth = 0; depth < MAX_VISIBILITY_DEPTH; ++depth) {
+    for (offset = -depth - 2; offset <= depth + 2; ++offset) {
+      cell = GPoint(g_player->position.x + forward.x * depth +
+                      rightward.x * offset,
+                    g_player->position.y + forward.y * depth +
+                      rightward.y * offset);
+      npc = get_npc_at(cell);
+      hash = HASH_COMBINE(hash, get_cell_type(cell));
+      hash = HASH_COMBINE(hash, gpoint_equal(&cell, &g_location->entrance));
+      hash = HASH_COMBINE(hash, npc ? npc->type : NONE);
+
+      // Every NPC type is animated once per second:
+      if (npc) {
+        hash = HASH_COMBINE(hash, time(0));
+      }
+    }
+  }
+
+  return hash;
+}
+
+/*******************************************************************************
+   Function: get_overlay_hash
+
+Description: Computes a compact hash of what "draw_overlay" shows apart from
+             animations (which request their own redraws): the player's current
+             and maximum health and energy. (The compass depends only on the
+             player's direction, which the scene hash covers.)
+
+     Inputs: None.
+
+    Outputs: The overlay hash.
+*******************************************************************************/
+uint32_t get_overlay_hash(void) {
+  int8_t i;
+  uint32_t hash = SCENE_HASH_OFFSET_BASIS;
+  const int16_t stats[NUM_OVERLAY_STATS] = {
+    g_player->int16_stats[CURRENT_HEALTH],
+    g_player->int16_stats[MAX_HEALTH],
+    g_player->int16_stats[CURRENT_ENERGY],
+    g_player->int16_stats[MAX_ENERGY],
+  };
+
+  for (i = 0; i < NUM_OVERLAY_STATS; ++i) {
+    hash = HASH_COMBINE(hash, stats[i]);
+    hash = HASH_COMBINE(hash, stats[i] >> 8);
+  }
+
+  return hash;
+}
+
 /*******************************************************************************
    Function: draw_scene
 
 Description: Draws a (simplistic) 3D scene based on the player's current
-             position, direction, and visibility depth.
+             position, direction, and visibility depth. If the scene hash
+             matches that of the cached scene, the latter is copied back
+             instead. (Scenes with random colors, i.e. mages' eyes, aren't
+             cached.)
 
      Inputs: layer - Pointer to the relevant layer.
              ctx   - Pointer to the relevant graphics context.
@@ -1262,50 +1951,100 @@ Description: Draws a (simplistic) 3D scene based on the player's current
     Outputs: None.
 *******************************************************************************/
 void draw_scene(Layer *layer, GContext *ctx) {
-  int8_t i, depth, spell_beam_width, magic_type = NONE;
-  GPoint cell, cell_2;
-  npc_t *mage = &g_location->npcs[0];
-  heavy_item_t *weapon = get_heavy_item_equipped_at(RIGHT_HAND);
+  int8_t i;
+  uint32_t scene_hash;
+  const view_cone_cell_t *view_cone_cell;
+
+  PROFILE_STAGE_START();
+  scene_hash = get_scene_hash();
+  if (g_scene_is_cached &&
+      scene_hash == g_scene_hash &&
+      copy_scene(ctx, true)) {
+    PROFILE_STAGE_END(SCENE_CACHE_STAGE);
+    return;
+  }
+  PROFILE_STAGE_END(SCENE_CACHE_STAGE);
 
   // First, draw the background, floor, and ceiling:
+  PROFILE_STAGE_START();
   graphics_context_set_fill_color(ctx, GColorBlack);
   graphics_fill_rect(ctx,
                      FULL_SCREEN_FRAME,
                      NO_CORNER_RADIUS,
                      GCornerNone);
   draw_floor_and_ceiling(ctx);
+  PROFILE_STAGE_END(FLOOR_AND_CEILING_STAGE);
+
+  // Now draw walls and cell contents (skipping cells hidden by nearer walls):
+  PROFILE_STAGE_START();
+  find_visible_cells();
+  PROFILE_STAGE_END(VISIBILITY_STAGE);
+  g_scene_has_random_colors = false;
+  for (i = 0; i < VIEW_CONE_NUM_CELLS; ++i) {
+    view_cone_cell = &g_view_cone[g_player->direction][i];
+    draw_cell(ctx,
+              GPoint(g_player->position.x + view_cone_cell->dx,
+                     g_player->position.y + view_cone_cell->dy),
+              view_cone_cell->depth,
+              view_cone_cell->position);
+  }
 
-  // Now draw walls and cell contents:
-  for (depth = MAX_VISIBILITY_DEPTH - 2; depth >= 0; --depth) {
-    // Straight ahead at the current depth:
-    cell = get_cell_farther_away(g_player->position,
-                                 g_player->direction,
-                                 depth);
-    if (get_cell_type(cell) >= EMPTY) {
-      draw_cell_walls(ctx, cell, depth, STRAIGHT_AHEAD);
-      draw_cell_contents(ctx, cell, depth, STRAIGHT_AHEAD);
-    }
-
-    // To the left and right at the same depth:
-    for (i = depth + 1; i > 0; --i) {
-      cell_2 = get_cell_farther_away(cell,
-                                 get_direction_to_the_left(g_player->direction),
-                                 i);
-      if (get_cell_type(cell_2) >= EMPTY) {
-        draw_cell_walls(ctx, cell_2, depth, STRAIGHT_AHEAD - i);
-        draw_cell_contents(ctx, cell_2, depth, STRAIGHT_AHEAD - i);
-      }
-      cell_2 = get_cell_farther_away(cell,
-                                get_direction_to_the_right(g_player->direction),
-                                i);
-      if (get_cell_type(cell_2) >= EMPTY) {
-        draw_cell_walls(ctx, cell_2, depth, STRAIGHT_AHEAD + i);
-        draw_cell_contents(ctx, cell_2, depth, STRAIGHT_AHEAD + i);
-      }
-    }
+  // Keep a copy for redraws that don't change the scene:
+  PROFILE_STAGE_START();
+  g_scene_is_cached = !g_scene_has_random_colors && copy_scene(ctx, false);
+  g_scene_hash = scene_hash;
+  PROFILE_STAGE_END(SCENE_CACHE_STAGE);
+}
+
+/*******************************************************************************
+   Function: draw_cell
+
+Description: Draws the walls and contents of a given cell, provided it isn't
+             hidden behind nearer walls.
+
+     Inputs: ctx      - Pointer to the relevant graphics context.
+             cell     - Coordinates of the cell of interest.
+             depth    - Front-back visual depth of the cell of interest in
+                        "g_back_wall_coords".
+             position - Left-right visual position of the cell of interest in
+                        "g_back_wall_coords".
+
+    Outputs: None.
+*******************************************************************************/
+void draw_cell(GContext *ctx,
+               const GPoint cell,
+               const int8_t depth,
+               const int8_t position) {
+  if (!g_cell_is_visible[depth][position]) {
+    return;
   }
+  PROFILE_STAGE_START();
+  draw_cell_walls(ctx, depth, position);
+  PROFILE_STAGE_END(WALLS_STAGE);
+  PROFILE_STAGE_START();
+  draw_cell_contents(ctx, cell, depth, position);
+  PROFILE_STAGE_END(CELL_CONTENTS_STAGE);
+}
+
+/*******************************************************************************
+   Function: draw_overlay
+
+Description: Draws everything that appears on top of the 3D scene: attack and
+             spell animations, status meters, and the compass.
+
+     Inputs: layer - Pointer to the relevant layer.
+             ctx   - Pointer to the relevant graphics context.
+
+    Outputs: None.
+*******************************************************************************/
+void draw_overlay(Layer *layer, GContext *ctx) {
+  int8_t i, spell_beam_width, magic_type = NONE;
+  GPoint cell, cell_2;
+  npc_t *mage = &g_location->npcs[g_enemy_spell_caster];
+  heavy_item_t *weapon = get_heavy_item_equipped_at(RIGHT_HAND);
 
   // Draw the "attack slash," if applicable:
+  PROFILE_STAGE_START();
   if (g_player_is_attacking) {
     if (weapon) {
       magic_type = weapon->infused_pebble;
@@ -1327,7 +2066,10 @@ void draw_scene(Layer *layer, GContext *ctx) {
     }
   }
 
+  PROFILE_STAGE_END(ATTACK_SLASH_STAGE);
+
   // Draw "spell beams," if applicable:
+  PROFILE_STAGE_START();
   if (g_player_current_spell_animation > 0) {
     spell_beam_width = g_player_current_spell_animation % 2 ?
                          MIN_SPELL_BEAM_BASE_WIDTH          :
@@ -1392,12 +2134,15 @@ void draw_scene(Layer *layer, GContext *ctx) {
     }
   }
 
+  PROFILE_STAGE_END(SPELL_BEAMS_STAGE);
+
   // Draw health meter:
+  PROFILE_STAGE_START();
   draw_status_meter(ctx,
                     GPoint(STATUS_METER_PADDING,
                            GRAPHICS_FRAME_HEIGHT + STATUS_METER_PADDING +
                              STATUS_BAR_HEIGHT),
-                    (float) g_player->int16_stats[CURRENT_HEALTH] /
+                    INT_TO_FIXED(g_player->int16_stats[CURRENT_HEALTH]) /
                       g_player->int16_stats[MAX_HEALTH]);
 
   // Draw energy meter:
@@ -1406,10 +2151,13 @@ void draw_scene(Layer *layer, GContext *ctx) {
                              COMPASS_RADIUS + 1,
                            GRAPHICS_FRAME_HEIGHT + STATUS_METER_PADDING +
                              STATUS_BAR_HEIGHT),
-                    (float) g_player->int16_stats[CURRENT_ENERGY] /
+                    INT_TO_FIXED(g_player->int16_stats[CURRENT_ENERGY]) /
                       g_player->int16_stats[MAX_ENERGY]);
 
+  PROFILE_STAGE_END(STATUS_METERS_STAGE);
+
   // Draw compass:
+  PROFILE_STAGE_START();
   graphics_context_set_fill_color(ctx, GColorLightGray);
   graphics_context_set_stroke_color(ctx, GColorDarkGreen);
   graphics_fill_circle(ctx,
@@ -1420,134 +2168,667 @@ void draw_scene(Layer *layer, GContext *ctx) {
   graphics_context_set_fill_color(ctx, GColorBlack);
   gpath_draw_outline(ctx, g_compass_path);
   gpath_draw_filled(ctx, g_compass_path);
+  PROFILE_STAGE_END(COMPASS_STAGE);
+
+  g_overlay_hash = get_overlay_hash();
+
+  // Finally, keep the backlight on:
+  keep_backlight_on();
+#ifdef LOG_FRAME_CHECKSUMS
+  log_frame_checksum(ctx);
+#endif
+#ifdef PROFILE_FRAME_STAGES
+  end_profiled_frame();
+#endif
+}
+
+/*******************************************************************************
+   Function: keep_backlight_on
+
+Description: Requests the backlight, which stays on for a while after each
+             request (with LIMIT_BACKLIGHT_REQUESTS, at most once every
+             BACKLIGHT_REQUEST_INTERVAL seconds). Called on every redraw, and
+             on every tick of active gameplay that skips its redraw.
+
+     Inputs: None.
 
-  // Finally, ensure the backlight is on:
+    Outputs: None.
+*******************************************************************************/
+void keep_backlight_on(void) {
+#ifdef LIMIT_BACKLIGHT_REQUESTS
+  if (time(0) - g_last_backlight_request < BACKLIGHT_REQUEST_INTERVAL) {
+    return;
+  }
+  g_last_backlight_request = time(0);
+#endif
   light_enable_interaction();
+  g_power_counters[BACKLIGHT_REQUESTS]++;
 }
 
+#ifdef LOG_FRAME_CHECKSUMS
 /*******************************************************************************
-   Function: draw_floor_and_ceiling
+   Function: log_frame_checksum
 
-Description: Draws the floor and ceiling.
+Description: Logs the player's position and direction along with a checksum of
+             the frame buffer below the top status bar, so rendered frames can
+             be compared against a known-good log.
 
      Inputs: ctx - Pointer to the relevant graphics context.
 
     Outputs: None.
 *******************************************************************************/
-void draw_floor_and_ceiling(GContext *ctx) {
-  uint8_t x, y, max_y, shading_offset;
-
-  max_y = g_back_wall_coords[MAX_VISIBILITY_DEPTH - 2][0][TOP_LEFT].y;
-  for (y = 0; y < max_y; ++y) {
-    // Determine horizontal distance between points:
-    shading_offset = 1 + y / MAX_VISIBILITY_DEPTH;
-    if (y % MAX_VISIBILITY_DEPTH >= MAX_VISIBILITY_DEPTH / 2 +
-                                    MAX_VISIBILITY_DEPTH % 2) {
-      shading_offset++;
-    }
-    graphics_context_set_stroke_color(ctx,
-      g_background_colors[g_location->floor_color_scheme]
-                         [shading_offset > NUM_BACKGROUND_COLORS_PER_SCHEME ?
-                            NUM_BACKGROUND_COLORS_PER_SCHEME - 1            :
-                            shading_offset - 1]);
-    for (x = y % 2 ? 0 : (shading_offset / 2) + (shading_offset % 2);
-         x < GRAPHICS_FRAME_WIDTH;
-         x += shading_offset) {
-      // Draw one point on the ceiling and another on the floor:
-      graphics_draw_pixel(ctx, GPoint(x, y + STATUS_BAR_HEIGHT));
-      graphics_draw_pixel(ctx, GPoint(x, GRAPHICS_FRAME_HEIGHT - y +
-                                           STATUS_BAR_HEIGHT));
+void log_frame_checksum(GContext *ctx) {
+  int16_t x, y;
+  uint16_t bytes_per_row;
+  uint8_t *frame_data;
+  uint32_t checksum = SCENE_HASH_OFFSET_BASIS;
+  GBitmap *frame_buffer = graphics_capture_frame_buffer(ctx);
+
+  if (frame_buffer == NULL) {
+    return;
+  }
+  frame_data = gbitmap_get_data(frame_buffer);
+  bytes_per_row = gbitmap_get_bytes_per_row(frame_buffer);
+  for (y = STATUS_BAR_HEIGHT; y < SCREEN_HEIGHT; ++y) {
+    for (x = 0; x < SCREEN_WIDTH; ++x) {
+      checksum = HASH_COMBINE(checksum, frame_data[y * bytes_per_row + x]);
     }
   }
+  graphics_release_frame_buffer(ctx, frame_buffer);
+  APP_LOG(APP_LOG_LEVEL_DEBUG,
+          "frame (%d, %d) %d: %08lx",
+          g_player->position.x,
+          g_player->position.y,
+          g_player->direction,
+          (unsigned long) checksum);
 }
+#endif
 
+#if defined(PROFILE_FRAME_STAGES) || defined(BENCHMARK_RENDERING)
 /*******************************************************************************
-   Function: draw_cell_walls
+   Function: get_time_in_ms
 
-Description: Draws any walls that exist along the back and sides of a given
-             cell.
+Description: Returns the current time in milliseconds, modulo 2^16, for timing
+             frames and frame stages. (Stages are summed from many short
+             intervals, so whole-millisecond readings average out to the true
+             time over a profiler report's worth of frames.)
 
-     Inputs: ctx      - Pointer to the relevant graphics context.
-             cell     - Coordinates of the cell of interest.
-             depth    - Front-back visual depth of the cell of interest in
-                        "g_back_wall_coords".
-             position - Left-right visual position of the cell of interest in
-                        "g_back_wall_coords".
+     Inputs: None.
 
-    Outputs: None.
+    Outputs: The current time in milliseconds (wrapping).
 *******************************************************************************/
-void draw_cell_walls(GContext *ctx,
-                     const GPoint cell,
-                     const int8_t depth,
-                     const int8_t position) {
-  int16_t left, right, top, bottom, y_offset;
-  bool back_wall_drawn, left_wall_drawn, right_wall_drawn;
-  GPoint cell_2;
+uint16_t get_time_in_ms(void) {
+  time_t seconds;
+  uint16_t milliseconds;
 
-  // Back wall:
-  left = g_back_wall_coords[depth][position][TOP_LEFT].x;
-  right = g_back_wall_coords[depth][position][BOTTOM_RIGHT].x;
-  top = g_back_wall_coords[depth][position][TOP_LEFT].y;
-  bottom = g_back_wall_coords[depth][position][BOTTOM_RIGHT].y;
-  if (bottom - top < MIN_WALL_HEIGHT) {
+  time_ms(&seconds, &milliseconds);
+
+  return (uint16_t) (seconds * 1000 + milliseconds);
+}
+#endif
+
+#ifdef PROFILE_FRAME_STAGES
+/*******************************************************************************
+   Function: end_profiled_frame
+
+Description: Stores the current frame's stage times in the profiler's ring
+             buffer and resets them. Once every PROFILER_NUM_FRAMES frames,
+             logs the min./avg./max. time of each stage (and of whole frames)
+             over the buffered frames.
+
+     Inputs: None.
+
+    Outputs: None.
+*******************************************************************************/
+void end_profiled_frame(void) {
+  int8_t i, j, k;
+  uint16_t min, max, frame_time;
+  uint32_t total;
+
+  memcpy(g_profiler_frames[g_profiler_frame_index],
+         g_profiler_stage_times,
+         sizeof(g_profiler_stage_times));
+  memset(g_profiler_stage_times, 0, sizeof(g_profiler_stage_times));
+  g_profiler_frame_index = (g_profiler_frame_index + 1) % PROFILER_NUM_FRAMES;
+  if (g_profiler_frame_index > 0) {
     return;
   }
-  back_wall_drawn = left_wall_drawn = right_wall_drawn = false;
-  cell_2 = get_cell_farther_away(cell, g_player->direction, 1);
-  if (get_cell_type(cell_2) <= SOLID) {
-    draw_shaded_quad(ctx,
-                     GPoint(left, top + STATUS_BAR_HEIGHT),
-                     GPoint(left, bottom + STATUS_BAR_HEIGHT),
-                     GPoint(right, top + STATUS_BAR_HEIGHT),
-                     GPoint(right, bottom + STATUS_BAR_HEIGHT),
-                     GPoint(left, top + STATUS_BAR_HEIGHT));
-    graphics_context_set_stroke_color(ctx, GColorBlack);
-    graphics_draw_line(ctx,
-                       GPoint(left, top + STATUS_BAR_HEIGHT),
-                       GPoint(right, top + STATUS_BAR_HEIGHT));
-    graphics_draw_line(ctx,
-                       GPoint(left, bottom + STATUS_BAR_HEIGHT),
-                       GPoint(right, bottom + STATUS_BAR_HEIGHT));
 
-    // Ad hoc solution to a minor visual issue (remove if no longer relevant):
-    if (top == g_back_wall_coords[1][0][TOP_LEFT].y) {
-      graphics_draw_line(ctx,
-                         GPoint(left, bottom + 1 + STATUS_BAR_HEIGHT),
-                         GPoint(right, bottom + 1 + STATUS_BAR_HEIGHT));
+  // Stage "NUM_PROFILER_STAGES" stands for whole frames:
+  for (i = 0; i <= NUM_PROFILER_STAGES; ++i) {
+    min   = UINT16_MAX;
+    max   = 0;
+    total = 0;
+    for (j = 0; j < PROFILER_NUM_FRAMES; ++j) {
+      if (i < NUM_PROFILER_STAGES) {
+        frame_time = g_profiler_frames[j][i];
+      } else {
+        frame_time = 0;
+        for (k = 0; k < NUM_PROFILER_STAGES; ++k) {
+          frame_time += g_profiler_frames[j][k];
+        }
+      }
+      if (frame_time < min) {
+        min = frame_time;
+      }
+      if (frame_time > max) {
+        max = frame_time;
+      }
+      total += frame_time;
     }
-
-    back_wall_drawn = true;
+    APP_LOG(APP_LOG_LEVEL_DEBUG,
+            "%s: min %u, avg %lu.%lu, max %u ms",
+            i < NUM_PROFILER_STAGES ? g_profiler_stage_names[i] : "frame",
+            min,
+            (unsigned long) (total / PROFILER_NUM_FRAMES),
+            (unsigned long) (total * 10 / PROFILER_NUM_FRAMES % 10),
+            max);
   }
+}
+#endif
 
-  // Left wall:
-  right = left;
-  if (depth == 0) {
-    left = 0;
-    y_offset = top;
-  } else {
-    left = g_back_wall_coords[depth - 1][position][TOP_LEFT].x;
-    y_offset = top - g_back_wall_coords[depth - 1][position][TOP_LEFT].y;
-  }
-  if (position <= STRAIGHT_AHEAD) {
-    cell_2 = get_cell_farther_away(cell,
-                                 get_direction_to_the_left(g_player->direction),
-                                 1);
-    if (get_cell_type(cell_2) <= SOLID) {
-      draw_shaded_quad(ctx,
-                       GPoint(left, top - y_offset + STATUS_BAR_HEIGHT),
-                       GPoint(left, bottom + y_offset + STATUS_BAR_HEIGHT),
-                       GPoint(right, top + STATUS_BAR_HEIGHT),
-                       GPoint(right, bottom + STATUS_BAR_HEIGHT),
-                       GPoint(left, top - y_offset + STATUS_BAR_HEIGHT));
-      graphics_context_set_stroke_color(ctx, GColorBlack);
-      graphics_draw_line(ctx,
-                         GPoint(left, top - y_offset + STATUS_BAR_HEIGHT),
-                         GPoint(right, top + STATUS_BAR_HEIGHT));
-      graphics_draw_line(ctx,
-                         GPoint(left, bottom + y_offset + STATUS_BAR_HEIGHT),
-                         GPoint(right, bottom + STATUS_BAR_HEIGHT));
-      left_wall_drawn = true;
-    }
+#ifdef BENCHMARK_RENDERING
+/*******************************************************************************
+   Function: start_benchmark
+
+Description: Saves the current location and the player's position and
+             direction, then loads the first benchmark map and has the scene
+             layer draw benchmark frames until every map has been covered.
+
+     Inputs: None.
+
+    Outputs: None.
+*******************************************************************************/
+void start_benchmark(void) {
+  g_benchmark_saved_location = malloc(sizeof(location_t));
+  if (g_benchmark_saved_location == NULL) {
+    return;
+  }
+  memcpy(g_benchmark_saved_location, g_location, sizeof(location_t));
+  g_benchmark_saved_position = g_player->position;
+  g_benchmark_saved_direction = g_player->direction;
+  g_benchmark_map = CORRIDORS_BENCHMARK_MAP;
+  load_benchmark_map(g_benchmark_map);
+  set_next_benchmark_pose();
+  layer_set_update_proc(g_scene_layer, draw_benchmark_frame);
+}
+
+/*******************************************************************************
+   Function: end_benchmark
+
+Description: Restores the location and player state saved by
+             "start_benchmark" and returns the scene layer to normal drawing.
+
+     Inputs: None.
+
+    Outputs: None.
+*******************************************************************************/
+void end_benchmark(void) {
+  memcpy(g_location, g_benchmark_saved_location, sizeof(location_t));
+  init_npc_pool();
+  init_map_caches();
+  free(g_benchmark_saved_location);
+  g_benchmark_saved_location = NULL;
+  g_player->position = g_benchmark_saved_position;
+  set_player_direction(g_benchmark_saved_direction);
+  g_benchmark_map = NONE;
+  g_scene_is_cached = false;
+  layer_set_update_proc(g_scene_layer, draw_scene);
+}
+
+/*******************************************************************************
+   Function: load_benchmark_map
+
+Description: Replaces the current location with a given benchmark map (tiled,
+             if the map is larger) and resets the benchmark's statistics.
+
+     Inputs: map - Index value for "g_benchmark_maps".
+
+    Outputs: None.
+*******************************************************************************/
+void load_benchmark_map(const int8_t map) {
+  int8_t i, j, npc_type = 0;
+  char c;
+  GPoint cell;
+
+  g_location->floor_color_scheme = g_location->wall_color_scheme = 0;
+  g_location->entrance = GPoint(NONE, NONE);
+  for (i = 0; i < MAX_NPCS_AT_ONE_TIME; ++i) {
+    g_location->npcs[i].type = NONE;
+  }
+  init_npc_pool();
+  clear_map();
+  g_player->position = GPoint(NONE, NONE);  // So it can't block NPCs.
+  for (i = 0; i < MAP_WIDTH; ++i) {
+    for (j = 0; j < MAP_HEIGHT; ++j) {
+      cell = GPoint(i, j);
+      c = g_benchmark_maps[map][(j % BENCHMARK_MAP_SIZE) * BENCHMARK_MAP_SIZE +
+                                i % BENCHMARK_MAP_SIZE];
+      set_cell_type(cell, c == '#' ? SOLID          :
+                          c == 'X' ? EXIT           :
+                          c == 'L' ? BENCHMARK_LOOT :
+                                     EMPTY);
+      if (c == 'E' && g_location->entrance.x == NONE) {
+        g_location->entrance = cell;
+      } else if (c == 'N' && add_new_npc(npc_type, cell)) {
+        npc_type = (npc_type + 1) % NUM_NPC_TYPES;
+      }
+    }
+  }
+  g_benchmark_pose = NONE;
+  g_benchmark_num_frames = 0;
+  memset(g_benchmark_frame_times, 0, sizeof(g_benchmark_frame_times));
+  memset(g_benchmark_frame_draw_calls,
+         0,
+         sizeof(g_benchmark_frame_draw_calls));
+}
+
+/*******************************************************************************
+   Function: set_next_benchmark_pose
+
+Description: Moves the player to the next benchmark pose: each open cell of the
+             current map (in row order), facing each direction in turn.
+
+     Inputs: None.
+
+    Outputs: "False" if every pose on the current map has been covered.
+*******************************************************************************/
+bool set_next_benchmark_pose(void) {
+  GPoint cell;
+
+  while (++g_benchmark_pose < MAP_WIDTH * MAP_HEIGHT * NUM_DIRECTIONS) {
+    cell = GPoint(g_benchmark_pose / NUM_DIRECTIONS % MAP_WIDTH,
+                  g_benchmark_pose / NUM_DIRECTIONS / MAP_WIDTH);
+    if (get_cell_type(cell) >= EMPTY && get_npc_at(cell) == NULL) {
+      g_player->position = cell;
+      set_player_direction(g_benchmark_pose % NUM_DIRECTIONS);
+
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/*******************************************************************************
+   Function: draw_benchmark_frame
+
+Description: Scene layer update procedure while benchmarking. Draws (and
+             times) an uncached scene for the current pose, then moves on to
+             the next pose or map and requests another frame.
+
+     Inputs: layer - Pointer to the relevant layer.
+             ctx   - Pointer to the relevant graphics context.
+
+    Outputs: None.
+*******************************************************************************/
+void draw_benchmark_frame(Layer *layer, GContext *ctx) {
+  uint16_t frame_time, draw_calls = g_benchmark_draw_calls;
+
+  g_scene_is_cached = false;
+  frame_time = get_time_in_ms();
+  draw_scene(layer, ctx);
+  frame_time = get_time_in_ms() - frame_time;
+  draw_calls = g_benchmark_draw_calls - draw_calls;
+  g_benchmark_frame_times[frame_time < BENCHMARK_HISTOGRAM_SIZE ?
+                            frame_time : BENCHMARK_HISTOGRAM_SIZE - 1]++;
+  g_benchmark_frame_draw_calls[draw_calls < BENCHMARK_HISTOGRAM_SIZE ?
+                                 draw_calls : BENCHMARK_HISTOGRAM_SIZE - 1]++;
+  g_benchmark_num_frames++;
+
+  // Move on to the next pose, the next map, or back to the game:
+  if (!set_next_benchmark_pose()) {
+    log_benchmark_results();
+    if (++g_benchmark_map < NUM_BENCHMARK_MAPS) {
+      load_benchmark_map(g_benchmark_map);
+      set_next_benchmark_pose();
+    } else {
+      end_benchmark();
+    }
+  }
+  app_timer_register(DEFAULT_TIMER_DURATION, benchmark_timer_callback, NULL);
+}
+
+/*******************************************************************************
+   Function: log_benchmark_results
+
+Description: Logs frame time and draw call percentiles for the current
+             benchmark map.
+
+     Inputs: None.
+
+    Outputs: None.
+*******************************************************************************/
+void log_benchmark_results(void) {
+  APP_LOG(APP_LOG_LEVEL_DEBUG,
+          "benchmark map %d: %u frames, p50/p95/p99 %u/%u/%u ms, "
+            "%u/%u/%u draw calls",
+          g_benchmark_map,
+          g_benchmark_num_frames,
+          get_histogram_percentile(g_benchmark_frame_times,
+                                   g_benchmark_num_frames,
+                                   50),
+          get_histogram_percentile(g_benchmark_frame_times,
+                                   g_benchmark_num_frames,
+                                   95),
+          get_histogram_percentile(g_benchmark_frame_times,
+                                   g_benchmark_num_frames,
+                                   99),
+          get_histogram_percentile(g_benchmark_frame_draw_calls,
+                                   g_benchmark_num_frames,
+                                   50),
+          get_histogram_percentile(g_benchmark_frame_draw_calls,
+                                   g_benchmark_num_frames,
+                                   95),
+          get_histogram_percentile(g_benchmark_frame_draw_calls,
+                                   g_benchmark_num_frames,
+                                   99));
+}
+
+/*******************************************************************************
+   Function: get_histogram_percentile
+
+Description: Returns the smallest benchmark histogram bucket at or below which
+             a given percentage of samples fall.
+
+     Inputs: histogram   - Pointer to the histogram (BENCHMARK_HISTOGRAM_SIZE
+                           buckets).
+             num_samples - Total number of samples in the histogram.
+             percentile  - Percentage of interest (0-100).
+
+    Outputs: Index of the bucket.
+*******************************************************************************/
+uint8_t get_histogram_percentile(const uint16_t *const histogram,
+                                 const uint16_t num_samples,
+                                 const uint8_t percentile) {
+  uint8_t i;
+  uint32_t count = 0;
+
+  for (i = 0; i < BENCHMARK_HISTOGRAM_SIZE - 1; ++i) {
+    count += histogram[i];
+    if (count * 100 >= (uint32_t) num_samples * percentile) {
+      break;
+    }
+  }
+
+  return i;
+}
+#endif
+
+/*******************************************************************************
+   Function: copy_scene
+
+Description: Copies the scene area of the frame buffer (everything below the top
+             status bar) into the scene bitmap, or vice versa.
+
+     Inputs: ctx     - Pointer to the relevant graphics context.
+             restore - If "true", the scene bitmap is copied into the frame
+                       buffer rather than the other way around.
+
+    Outputs: "True" if the copy was made.
+*******************************************************************************/
+bool copy_scene(GContext *ctx, const bool restore) {
+  uint8_t y, *frame_row, *scene_row;
+  uint16_t bytes_per_row;
+  GBitmap *frame_buffer;
+
+  if (g_scene_bitmap == NULL ||
+      (frame_buffer = graphics_capture_frame_buffer(ctx)) == NULL) {
+    return false;
+  }
+  bytes_per_row = gbitmap_get_bytes_per_row(frame_buffer);
+  for (y = 0; y < SCREEN_HEIGHT - STATUS_BAR_HEIGHT; ++y) {
+    frame_row = gbitmap_get_data(frame_buffer) +
+                  (y + STATUS_BAR_HEIGHT) * bytes_per_row;
+    scene_row = gbitmap_get_data(g_scene_bitmap) +
+                  y * gbitmap_get_bytes_per_row(g_scene_bitmap);
+    if (restore) {
+      memcpy(frame_row, scene_row, SCREEN_WIDTH);
+    } else {
+      memcpy(scene_row, frame_row, SCREEN_WIDTH);
+    }
+  }
+  graphics_release_frame_buffer(ctx, frame_buffer);
+
+  return true;
+}
+
+/*******************************************************************************
+   Function: get_view_cone_solid_mask
+
+Description: Determines which cells of a given row of the view cone are solid,
+             as a single span of the solid-cell bitboard running across the
+             player's line of sight.
+
+     Inputs: depth - Front-back visual depth of the row (up to
+                     MAX_VISIBILITY_DEPTH - 1, the row behind the farthest one
+                     drawn).
+
+    Outputs: A mask with bit "position + 1" set if the cell at that left-right
+             visual position is solid, for positions -1 through
+             (STRAIGHT_AHEAD * 2) + 1.
+*******************************************************************************/
+uint16_t get_view_cone_solid_mask(const int8_t depth) {
+  int8_t i;
+  uint16_t mask = 0;
+  uint32_t span;
+  const GPoint forward = g_direction_vectors[g_player->direction],
+               rightward = g_direction_vectors[g_directions_to_the_right
+                                                 [g_player->direction]];
+
+  // Read the row from its western (or northern) end:
+  span = get_solid_cell_span(
+           GPoint(g_player->position.x + forward.x * depth -
+                    abs(rightward.x) * (STRAIGHT_AHEAD + 1),
+                  g_player->position.y + forward.y * depth -
+                    abs(rightward.y) * (STRAIGHT_AHEAD + 1)),
+           rightward.y != 0,
+           VIEW_CONE_MASK_WIDTH);
+  if (rightward.x + rightward.y > 0) {
+    return span;
+  }
+
+  // The player's right is west (or north), so reverse it:
+  for (i = 0; i < VIEW_CONE_MASK_WIDTH; ++i) {
+    mask = mask << 1 | (span >> i & 1);
+  }
+
+  return mask;
+}
+
+/*******************************************************************************
+   Function: find_visible_cells
+
+Description: Walks the view cone front to back, tracking which screen columns
+             are already hidden behind solid back walls, and flags each
+             non-solid cell that may still contribute pixels to the scene in
+             "g_cell_is_visible". (Everything drawn for a cell lies between its
+             own back wall and the one in front of it, vertically within the
+             latter, so once all of those columns are covered by nearer back
+             walls, nothing it draws can show through.) Also refreshes
+             "g_view_cone_solid_masks", for this and "draw_cell_walls".
+
+     Inputs: None.
+
+    Outputs: None.
+*******************************************************************************/
+void find_visible_cells(void) {
+  int8_t depth, position;
+  int16_t left, right, x;
+  bool column_is_covered[GRAPHICS_FRAME_WIDTH];
+
+  for (depth = 0; depth < MAX_VISIBILITY_DEPTH; ++depth) {
+    g_view_cone_solid_masks[depth] = get_view_cone_solid_mask(depth);
+  }
+  memset(column_is_covered, 0, sizeof(column_is_covered));
+  memset(g_cell_is_visible, 0, sizeof(g_cell_is_visible));
+  for (depth = 0; depth < MAX_VISIBILITY_DEPTH - 1; ++depth) {
+    // First, check each cell against walls at lesser depths:
+    for (position = STRAIGHT_AHEAD - depth - 1;
+         position <= STRAIGHT_AHEAD + depth + 1;
+         ++position) {
+      if (VIEW_CONE_CELL_IS_SOLID(depth, position)) {
+        continue;
+      }
+      if (depth == 0) {
+        g_cell_is_visible[depth][position] = true;
+        continue;
+      }
+      left = g_back_wall_coords[depth - 1][position][TOP_LEFT].x;
+      if (g_back_wall_coords[depth][position][TOP_LEFT].x < left) {
+        left = g_back_wall_coords[depth][position][TOP_LEFT].x;
+      }
+      right = g_back_wall_coords[depth - 1][position][BOTTOM_RIGHT].x;
+      if (g_back_wall_coords[depth][position][BOTTOM_RIGHT].x > right) {
+        right = g_back_wall_coords[depth][position][BOTTOM_RIGHT].x;
+      }
+      for (x = left < 0 ? 0 : left;
+           x <= right && x < GRAPHICS_FRAME_WIDTH;
+           ++x) {
+        if (!column_is_covered[x]) {
+          g_cell_is_visible[depth][position] = true;
+          break;
+        }
+      }
+    }
+
+    // Then add the back walls drawn at this depth to the coverage buffer:
+    for (position = STRAIGHT_AHEAD - depth - 1;
+         position <= STRAIGHT_AHEAD + depth + 1;
+         ++position) {
+      if (g_cell_is_visible[depth][position] &&
+          g_back_wall_coords[depth][position][BOTTOM_RIGHT].y -
+            g_back_wall_coords[depth][position][TOP_LEFT].y >=
+            MIN_WALL_HEIGHT &&
+          VIEW_CONE_CELL_IS_SOLID(depth + 1, position)) {
+        left = g_back_wall_coords[depth][position][TOP_LEFT].x;
+        right = g_back_wall_coords[depth][position][BOTTOM_RIGHT].x;
+        for (x = left < 0 ? 0 : left;
+             x <= right && x < GRAPHICS_FRAME_WIDTH;
+             ++x) {
+          column_is_covered[x] = true;
+        }
+      }
+    }
+  }
+}
+
+/*******************************************************************************
+   Function: draw_floor_and_ceiling
+
+Description: Draws the floor and ceiling by copying rows of the cached floor and
+             ceiling bitmap (rebuilt only when the floor color scheme changes)
+             into the frame buffer. Nothing is drawn if there wasn't enough
+             memory for the bitmap.
+
+     Inputs: ctx - Pointer to the relevant graphics context.
+
+    Outputs: None.
+*******************************************************************************/
+void draw_floor_and_ceiling(GContext *ctx) {
+  uint8_t y, max_y, *frame_data, *row;
+  uint16_t bytes_per_row;
+  GBitmap *frame_buffer;
+
+  if (g_floor_and_ceiling_bitmap == NULL) {
+    return;  // Out of memory, so the floor and ceiling are left blank.
+  }
+  if (g_floor_and_ceiling_color_scheme != g_location->floor_color_scheme) {
+    init_floor_and_ceiling_bitmap();
+  }
+  frame_buffer = graphics_capture_frame_buffer(ctx);
+  if (frame_buffer == NULL) {
+    return;
+  }
+  frame_data = gbitmap_get_data(frame_buffer);
+  bytes_per_row = gbitmap_get_bytes_per_row(frame_buffer);
+
+  // Copy each row to the ceiling and its mirror image to the floor:
+  max_y = g_back_wall_coords[MAX_VISIBILITY_DEPTH - 2][0][TOP_LEFT].y;
+  for (y = 0; y < max_y; ++y) {
+    row = gbitmap_get_data(g_floor_and_ceiling_bitmap) +
+            y * gbitmap_get_bytes_per_row(g_floor_and_ceiling_bitmap);
+    memcpy(frame_data + (y + STATUS_BAR_HEIGHT) * bytes_per_row,
+           row,
+           GRAPHICS_FRAME_WIDTH);
+    memcpy(frame_data + (GRAPHICS_FRAME_HEIGHT - y + STATUS_BAR_HEIGHT) *
+                          bytes_per_row,
+           row,
+           GRAPHICS_FRAME_WIDTH);
+  }
+  graphics_release_frame_buffer(ctx, frame_buffer);
+}
+
+/*******************************************************************************
+   Function: draw_cell_walls
+
+Description: Draws any walls that exist along the back and sides of a given
+             cell, according to "g_view_cone_solid_masks".
+
+     Inputs: ctx      - Pointer to the relevant graphics context.
+             depth    - Front-back visual depth of the cell of interest in
+                        "g_back_wall_coords".
+             position - Left-right visual position of the cell of interest in
+                        "g_back_wall_coords".
+
+    Outputs: None.
+*******************************************************************************/
+void draw_cell_walls(GContext *ctx,
+                     const int8_t depth,
+                     const int8_t position) {
+  int16_t left, right, top, bottom, y_offset;
+  bool back_wall_drawn, left_wall_drawn, right_wall_drawn;
+
+  // Back wall:
+  left = g_back_wall_coords[depth][position][TOP_LEFT].x;
+  right = g_back_wall_coords[depth][position][BOTTOM_RIGHT].x;
+  top = g_back_wall_coords[depth][position][TOP_LEFT].y;
+  bottom = g_back_wall_coords[depth][position][BOTTOM_RIGHT].y;
+  if (bottom - top < MIN_WALL_HEIGHT) {
+    return;
+  }
+  back_wall_drawn = left_wall_drawn = right_wall_drawn = false;
+  if (VIEW_CONE_CELL_IS_SOLID(depth + 1, position)) {
+    draw_shaded_wall(ctx, depth, position, BACK_WALL);
+    graphics_context_set_stroke_color(ctx, GColorBlack);
+    graphics_draw_line(ctx,
+                       GPoint(left, top + STATUS_BAR_HEIGHT),
+                       GPoint(right, top + STATUS_BAR_HEIGHT));
+    graphics_draw_line(ctx,
+                       GPoint(left, bottom + STATUS_BAR_HEIGHT),
+                       GPoint(right, bottom + STATUS_BAR_HEIGHT));
+
+    // Ad hoc solution to a minor visual issue (remove if no longer relevant):
+    if (top == g_back_wall_coords[1][0][TOP_LEFT].y) {
+      graphics_draw_line(ctx,
+                         GPoint(left, bottom + 1 + STATUS_BAR_HEIGHT),
+                         GPoint(right, bottom + 1 + STATUS_BAR_HEIGHT));
+    }
+
+    back_wall_drawn = true;
+  }
+
+  // Left wall:
+  right = left;
+  if (depth == 0) {
+    left = 0;
+    y_offset = top;
+  } else {
+    left = g_back_wall_coords[depth - 1][position][TOP_LEFT].x;
+    y_offset = top - g_back_wall_coords[depth - 1][position][TOP_LEFT].y;
+  }
+  if (position <= STRAIGHT_AHEAD) {
+    if (VIEW_CONE_CELL_IS_SOLID(depth, position - 1)) {
+      draw_shaded_wall(ctx, depth, position, LEFT_WALL);
+      graphics_context_set_stroke_color(ctx, GColorBlack);
+      graphics_draw_line(ctx,
+                         GPoint(left, top - y_offset + STATUS_BAR_HEIGHT),
+                         GPoint(right, top + STATUS_BAR_HEIGHT));
+      graphics_draw_line(ctx,
+                         GPoint(left, bottom + y_offset + STATUS_BAR_HEIGHT),
+                         GPoint(right, bottom + STATUS_BAR_HEIGHT));
+      left_wall_drawn = true;
+    }
   }
 
   // Right wall:
@@ -1558,16 +2839,8 @@ void draw_cell_walls(GContext *ctx,
     right = g_back_wall_coords[depth - 1][position][BOTTOM_RIGHT].x;
   }
   if (position >= STRAIGHT_AHEAD) {
-    cell_2 = get_cell_farther_away(cell,
-                                get_direction_to_the_right(g_player->direction),
-                                1);
-    if (get_cell_type(cell_2) <= SOLID) {
-      draw_shaded_quad(ctx,
-                       GPoint(left, top + STATUS_BAR_HEIGHT),
-                       GPoint(left, bottom + STATUS_BAR_HEIGHT),
-                       GPoint(right, top - y_offset + STATUS_BAR_HEIGHT),
-                       GPoint(right, bottom + y_offset + STATUS_BAR_HEIGHT),
-                       GPoint(left, top + STATUS_BAR_HEIGHT));
+    if (VIEW_CONE_CELL_IS_SOLID(depth, position + 1)) {
+      draw_shaded_wall(ctx, depth, position, RIGHT_WALL);
       graphics_context_set_stroke_color(ctx, GColorBlack);
       graphics_draw_line(ctx,
                          GPoint(left, top + STATUS_BAR_HEIGHT),
@@ -1581,15 +2854,9 @@ void draw_cell_walls(GContext *ctx,
 
   // Draw vertical lines at corners:
   graphics_context_set_stroke_color(ctx, GColorBlack);
-  cell_2 = get_cell_farther_away(cell, g_player->direction, 1);
   if ((back_wall_drawn && (left_wall_drawn ||
-       get_cell_type(get_cell_farther_away(cell_2,
-                                 get_direction_to_the_left(g_player->direction),
-                                 1)) >= EMPTY)) ||
-      (left_wall_drawn &&
-       get_cell_type(get_cell_farther_away(cell_2,
-                                 get_direction_to_the_left(g_player->direction),
-                                 1)) >= EMPTY)) {
+       !VIEW_CONE_CELL_IS_SOLID(depth + 1, position - 1))) ||
+      (left_wall_drawn && !VIEW_CONE_CELL_IS_SOLID(depth + 1, position - 1))) {
     graphics_draw_line(ctx,
                        GPoint(g_back_wall_coords[depth][position][TOP_LEFT].x,
                               g_back_wall_coords[depth][position][TOP_LEFT].y +
@@ -1599,13 +2866,8 @@ void draw_cell_walls(GContext *ctx,
                              STATUS_BAR_HEIGHT));
   }
   if ((back_wall_drawn && (right_wall_drawn ||
-       get_cell_type(get_cell_farther_away(cell_2,
-                                get_direction_to_the_right(g_player->direction),
-                                1)) >= EMPTY)) ||
-      (right_wall_drawn &&
-       get_cell_type(get_cell_farther_away(cell_2,
-                                get_direction_to_the_right(g_player->direction),
-                                1)) >= EMPTY)) {
+       !VIEW_CONE_CELL_IS_SOLID(depth + 1, position + 1))) ||
+      (right_wall_drawn && !VIEW_CONE_CELL_IS_SOLID(depth + 1, position + 1))) {
     graphics_draw_line(ctx,
                     GPoint(g_back_wall_coords[depth][position][BOTTOM_RIGHT].x,
                            g_back_wall_coords[depth][position][BOTTOM_RIGHT].y +
@@ -1635,7 +2897,7 @@ void draw_cell_contents(GContext *ctx,
                         const int8_t depth,
                         const int8_t position) {
   uint8_t drawing_unit;  // Reference variable for drawing contents at depth.
-  int16_t i, x_midpoint1, x_midpoint2;
+  int16_t x_midpoint1, x_midpoint2;
   GPoint floor_center_point, top_left_point;
   npc_t *npc = get_npc_at(cell);
 
@@ -1678,16 +2940,16 @@ void draw_cell_contents(GContext *ctx,
                  GPoint(floor_center_point.x,
                         GRAPHICS_FRAME_HEIGHT - floor_center_point.y +
                           STATUS_BAR_HEIGHT * 2),
-                 ELLIPSE_RADIUS_RATIO *
+                 FIXED_TO_INT(ELLIPSE_RADIUS_RATIO *
                    (g_back_wall_coords[depth][position][BOTTOM_RIGHT].x -
-                    top_left_point.x),
+                    top_left_point.x)),
                  depth == 0 ?
-                   ELLIPSE_RADIUS_RATIO *
+                   FIXED_TO_INT(ELLIPSE_RADIUS_RATIO *
                     (GRAPHICS_FRAME_HEIGHT -
-                     g_back_wall_coords[depth][position][BOTTOM_RIGHT].y) :
-                   ELLIPSE_RADIUS_RATIO *
+                     g_back_wall_coords[depth][position][BOTTOM_RIGHT].y)) :
+                   FIXED_TO_INT(ELLIPSE_RADIUS_RATIO *
                      (g_back_wall_coords[depth - 1][position][BOTTOM_RIGHT].y -
-                      g_back_wall_coords[depth][position][BOTTOM_RIGHT].y),
+                      g_back_wall_coords[depth][position][BOTTOM_RIGHT].y)),
                  GColorBlack);
   }
 
@@ -1695,16 +2957,16 @@ void draw_cell_contents(GContext *ctx,
   if (npc || get_cell_type(cell) >= EXIT) {
     fill_ellipse(ctx,
                  GPoint(floor_center_point.x, floor_center_point.y),
-                 ELLIPSE_RADIUS_RATIO *
+                 FIXED_TO_INT(ELLIPSE_RADIUS_RATIO *
                    (g_back_wall_coords[depth][position][BOTTOM_RIGHT].x -
-                    top_left_point.x),
+                    top_left_point.x)),
                  depth == 0 ?
-                   ELLIPSE_RADIUS_RATIO *
+                   FIXED_TO_INT(ELLIPSE_RADIUS_RATIO *
                     (GRAPHICS_FRAME_HEIGHT -
-                     g_back_wall_coords[depth][position][BOTTOM_RIGHT].y) :
-                   ELLIPSE_RADIUS_RATIO *
+                     g_back_wall_coords[depth][position][BOTTOM_RIGHT].y)) :
+                   FIXED_TO_INT(ELLIPSE_RADIUS_RATIO *
                       (g_back_wall_coords[depth - 1][position][BOTTOM_RIGHT].y -
-                       g_back_wall_coords[depth][position][BOTTOM_RIGHT].y),
+                       g_back_wall_coords[depth][position][BOTTOM_RIGHT].y)),
                  GColorBlack);
   }
 
@@ -1714,9 +2976,10 @@ void draw_cell_contents(GContext *ctx,
       graphics_context_set_fill_color(ctx, GColorYellow);
       graphics_fill_rect(ctx,
                          GRect(floor_center_point.x - drawing_unit * 2,
-                               floor_center_point.y - drawing_unit * 2.5,
+                               floor_center_point.y - drawing_unit * 2 -
+                                 (drawing_unit + 1) / 2,
                                drawing_unit * 4,
-                               drawing_unit * 2.5),
+                               drawing_unit * 2 + drawing_unit / 2),
                          drawing_unit / 2,
                          GCornersTop);
     }
@@ -1738,8 +3001,45 @@ void draw_cell_contents(GContext *ctx,
     drawing_unit++;
   }
 
-  // Mages:
+  // Mages' eyes take a new random color on every redraw:
   if (npc->type == MAGE) {
+    g_scene_has_random_colors = true;
+  }
+
+  // Draw the NPC from its cached sprite, if possible:
+  if (!draw_npc_sprite(ctx, npc->type, depth, floor_center_point,
+                       drawing_unit)) {
+    draw_npc(ctx, npc->type, depth, floor_center_point, drawing_unit,
+             npc->type == MAGE ? RANDOM_BRIGHT_COLOR : GColorBlack);
+  }
+}
+
+/*******************************************************************************
+   Function: draw_npc
+
+Description: Draws an NPC of a given type standing at a given floor point.
+
+     Inputs: ctx                - Pointer to the relevant graphics context.
+             npc_type           - Type of NPC to be drawn.
+             depth              - Front-back visual depth of the NPC's cell in
+                                  "g_back_wall_coords".
+             floor_center_point - Screen coordinates the NPC stands on.
+             drawing_unit       - Reference length for drawing at this depth,
+                                  already adjusted for the NPC's size.
+             eye_color          - Color of the NPC's eyes (mages only).
+
+    Outputs: None.
+*******************************************************************************/
+void draw_npc(GContext *ctx,
+              const int8_t npc_type,
+              const int8_t depth,
+              const GPoint floor_center_point,
+              const uint8_t drawing_unit,
+              const GColor eye_color) {
+  int16_t i;
+
+  // Mages:
+  if (npc_type == MAGE) {
     // Body:
     graphics_context_set_fill_color(ctx, GColorBlack);
     graphics_fill_rect(ctx,
@@ -1760,7 +3060,7 @@ void draw_cell_contents(GContext *ctx,
                        GCornersTop);
 
     // Eyes:
-    graphics_context_set_fill_color(ctx, RANDOM_BRIGHT_COLOR);
+    graphics_context_set_fill_color(ctx, eye_color);
     graphics_fill_circle(ctx,
                          GPoint(floor_center_point.x - drawing_unit / 3,
                                 floor_center_point.y - drawing_unit * 9),
@@ -1771,10 +3071,10 @@ void draw_cell_contents(GContext *ctx,
                          drawing_unit / 5);
 
   // Floating monsters:
-  } else if (npc->type <= WHITE_MONSTER_SMALL) {
+  } else if (npc_type <= WHITE_MONSTER_SMALL) {
     // Body/head:
     graphics_context_set_fill_color(ctx,
-                                    npc->type % 2 ? GColorDarkCandyAppleRed :
+                                    npc_type % 2 ? GColorDarkCandyAppleRed :
                                                     GColorBulgarianRose);
     graphics_fill_circle(ctx,
                          GPoint(floor_center_point.x,
@@ -1788,7 +3088,7 @@ void draw_cell_contents(GContext *ctx,
                  drawing_unit + 1,
                  drawing_unit / 2 + 1,
                  GColorPastelYellow);
-    graphics_context_set_fill_color(ctx, npc->type % 2 ? GColorVividCerulean :
+    graphics_context_set_fill_color(ctx, npc_type % 2 ? GColorVividCerulean :
                                                          GColorDukeBlue);
     graphics_fill_circle(ctx,
                          GPoint(floor_center_point.x, i),
@@ -1800,8 +3100,8 @@ void draw_cell_contents(GContext *ctx,
 
     // Mouth:
     for (i = floor_center_point.x - drawing_unit +
-               ((npc->type == BLACK_MONSTER_MEDIUM ||
-                 npc->type == WHITE_MONSTER_MEDIUM) ? 1 : 0);
+               ((npc_type == BLACK_MONSTER_MEDIUM ||
+                 npc_type == WHITE_MONSTER_MEDIUM) ? 1 : 0);
          i < floor_center_point.x + drawing_unit - drawing_unit / 4;
          i += drawing_unit / 2) {
       graphics_context_set_fill_color(ctx, GColorSunsetOrange);
@@ -1816,9 +3116,9 @@ void draw_cell_contents(GContext *ctx,
     }
 
   // Goblins, trolls, and ogres:
-  } else if (npc->type >= DARK_OGRE && npc->type <= PALE_GOBLIN) {
+  } else if (npc_type >= DARK_OGRE && npc_type <= PALE_GOBLIN) {
     // Legs:
-    graphics_context_set_fill_color(ctx, npc->type % 2 ? GColorLimerick :
+    graphics_context_set_fill_color(ctx, npc_type % 2 ? GColorLimerick :
                                                          GColorArmyGreen);
     graphics_fill_rect(ctx,
                        GRect(floor_center_point.x - drawing_unit * 2,
@@ -1887,7 +3187,7 @@ void draw_cell_contents(GContext *ctx,
     // Mouth:
     if (depth < 4) {
       for (i = floor_center_point.x - drawing_unit / 2 -
-                 (npc->type <= PALE_OGRE ? 1 : 0);
+                 (npc_type <= PALE_OGRE ? 1 : 0);
            i < floor_center_point.x + drawing_unit / 2;
            i += drawing_unit / 3) {
         graphics_context_set_fill_color(ctx, GColorSunsetOrange);
@@ -1999,87 +3299,335 @@ void draw_cell_contents(GContext *ctx,
 }
 
 /*******************************************************************************
-   Function: draw_shaded_quad
-
-Description: Draws a shaded quadrilateral according to specifications. Assumes
-             the left and right sides are parallel.
-
-     Inputs: ctx         - Pointer to the relevant graphics context.
-             upper_left  - Coordinates of the upper-left point.
-             lower_left  - Coordinates of the lower-left point.
-             upper_right - Coordinates of the upper-right point.
-             lower_right - Coordinates of the lower-right point.
-             shading_ref - Reference coordinates to assist in determining
-                           shading offset values for the quad's location in
-                           the 3D environment. (For walls, this is the same as
-                           "upper_left".)
-
-    Outputs: None.
+   Function: draw_npc_sprite
+
+Description: Draws an NPC by copying its pre-rendered sprite (for the NPC's
+             type, depth, and current animation frame) into the frame buffer,
+             rendering and caching the sprite first if necessary. Mages' eyes
+             are recolored on the fly.
+
+     Inputs: ctx                - Pointer to the relevant graphics context.
+             npc_type           - Type of NPC to be drawn.
+             depth              - Front-back visual depth of the NPC's cell in
+                                  "g_back_wall_coords".
+             floor_center_point - Screen coordinates the NPC stands on.
+             drawing_unit       - Reference length for drawing at this depth,
+                                  already adjusted for the NPC's size.
+
+    Outputs: "True" if the NPC was drawn. (If not, it must be drawn directly.)
 *******************************************************************************/
-void draw_shaded_quad(GContext *ctx,
-                      const GPoint upper_left,
-                      const GPoint lower_left,
-                      const GPoint upper_right,
-                      const GPoint lower_right,
-                      const GPoint shading_ref) {
-  int16_t i, j, shading_offset, half_shading_offset;
-  float dy_over_dx = (float) (upper_right.y - upper_left.y) /
-                             (upper_right.x - upper_left.x);
-  GColor primary_color = GColorWhite;
-
-  for (i = upper_left.x; i <= upper_right.x && i < GRAPHICS_FRAME_WIDTH; ++i) {
-    // Determine vertical distance between points:
-    shading_offset = 1 + ((shading_ref.y + (i - upper_left.x) * dy_over_dx) /
-                          MAX_VISIBILITY_DEPTH);
-    if ((int16_t) (shading_ref.y + (i - upper_left.x) * dy_over_dx) %
-        MAX_VISIBILITY_DEPTH >= MAX_VISIBILITY_DEPTH / 2 +
-                                MAX_VISIBILITY_DEPTH % 2) {
-      shading_offset++;
-    }
-    half_shading_offset = (shading_offset / 2) + (shading_offset % 2);
-    if (shading_offset - 3 > NUM_BACKGROUND_COLORS_PER_SCHEME) {
-      primary_color = g_background_colors[g_location->wall_color_scheme]
-                                         [NUM_BACKGROUND_COLORS_PER_SCHEME - 1];
-    } else if (shading_offset > 4) {
-      primary_color = g_background_colors[g_location->wall_color_scheme]
-                                         [shading_offset - 4];
-    } else {
-      primary_color = g_background_colors[g_location->wall_color_scheme][0];
+bool draw_npc_sprite(GContext *ctx,
+                     const int8_t npc_type,
+                     const int8_t depth,
+                     const GPoint floor_center_point,
+                     const uint8_t drawing_unit) {
+  int16_t x, y, left, top;
+  uint16_t bytes_per_row, sprite_bytes_per_row;
+  uint8_t *frame_data, *sprite_data, pixel, eye_color = 0;
+  int8_t i, frame = npc_type == MAGE ? 0 : time(0) % 2;
+  npc_sprite_t *sprite = NULL;
+  GBitmap *frame_buffer;
+  GSize size;
+
+  // Look for the sprite in the atlas:
+  for (i = 0; i < NPC_SPRITE_ATLAS_SIZE; ++i) {
+    if (g_npc_sprites[i].npc_type == npc_type &&
+        g_npc_sprites[i].depth == depth &&
+        g_npc_sprites[i].frame == frame) {
+      sprite = &g_npc_sprites[i];
+      break;
     }
+  }
+  if (sprite == NULL &&
+      (sprite = init_npc_sprite(ctx,
+                                npc_type,
+                                depth,
+                                frame,
+                                floor_center_point,
+                                drawing_unit)) == NULL) {
+    return false;
+  }
+  sprite->last_used = ++g_npc_sprite_clock;
+  if (npc_type == MAGE) {
+    eye_color = RANDOM_BRIGHT_COLOR.argb;
+  }
 
-    // Now, draw points from top to bottom:
-    for (j = upper_left.y + (i - upper_left.x) * dy_over_dx;
-         j < lower_left.y - (i - upper_left.x) * dy_over_dx;
-         ++j) {
-      if ((j + (int16_t) ((i - upper_left.x) * dy_over_dx) +
-          (i % 2 == 0 ? 0 : half_shading_offset)) % shading_offset == 0) {
-        graphics_context_set_stroke_color(ctx, primary_color);
-      } else {
-        graphics_context_set_stroke_color(ctx, GColorBlack);
+  // Copy every opaque pixel, clipped to the screen:
+  frame_buffer = graphics_capture_frame_buffer(ctx);
+  if (frame_buffer == NULL) {
+    return false;
+  }
+  frame_data = gbitmap_get_data(frame_buffer);
+  bytes_per_row = gbitmap_get_bytes_per_row(frame_buffer);
+  sprite_data = gbitmap_get_data(sprite->bitmap);
+  sprite_bytes_per_row = gbitmap_get_bytes_per_row(sprite->bitmap);
+  size = gbitmap_get_bounds(sprite->bitmap).size;
+  left = floor_center_point.x + sprite->x_offset;
+  top = floor_center_point.y + sprite->y_offset;
+  for (y = top < 0 ? 0 : top; y < top + size.h && y < SCREEN_HEIGHT; ++y) {
+    for (x = left < 0 ? 0 : left;
+         x < left + size.w && x < SCREEN_WIDTH;
+         ++x) {
+      pixel = sprite_data[(y - top) * sprite_bytes_per_row + x - left];
+      if (pixel == GColorClear.argb) {
+        continue;
       }
-      graphics_draw_pixel(ctx, GPoint(i, j));
+      frame_data[y * bytes_per_row + x] =
+        pixel == NPC_SPRITE_EYE_COLOR.argb && npc_type == MAGE ? eye_color :
+                                                                 pixel;
     }
   }
+  graphics_release_frame_buffer(ctx, frame_buffer);
+
+  return true;
 }
 
 /*******************************************************************************
-   Function: draw_status_meter
-
-Description: Draws a "status meter" (such as a "health meter") at a given point
-             according to given max. and current values of the attribute to be
-             represented.
+   Function: init_npc_sprite
+
+Description: Renders an NPC into the frame buffer over a transparent
+             background, stores the result in the NPC sprite atlas (evicting the
+             least recently used sprites as needed), then restores the frame
+             buffer. Sprites are only made when the NPC lies entirely on screen
+             and enough heap memory remains.
+
+     Inputs: ctx                - Pointer to the relevant graphics context.
+             npc_type           - Type of NPC to be rendered.
+             depth              - Front-back visual depth of the NPC's cell in
+                                  "g_back_wall_coords".
+             frame              - Animation frame (0 or 1).
+             floor_center_point - Screen coordinates the NPC stands on.
+             drawing_unit       - Reference length for drawing at this depth,
+                                  already adjusted for the NPC's size.
+
+    Outputs: Pointer to the new sprite, or NULL if none was made.
+*******************************************************************************/
+npc_sprite_t *init_npc_sprite(GContext *ctx,
+                              const int8_t npc_type,
+                              const int8_t depth,
+                              const int8_t frame,
+                              const GPoint floor_center_point,
+                              const uint8_t drawing_unit) {
+  int16_t x, y, min_x, min_y, max_x, max_y;
+  uint16_t bytes_per_row;
+  uint8_t *frame_data, *background_data;
+  int8_t i;
+  npc_sprite_t *sprite = NULL;
+  GBitmap *frame_buffer, *background;
+  const GRect box = GRect(floor_center_point.x - drawing_unit * 4,
+                          floor_center_point.y - drawing_unit * 11,
+                          drawing_unit * 8 + 1,
+                          drawing_unit * 11 + 1);
+
+  if (box.origin.x < 0 ||
+      box.origin.y < 0 ||
+      box.origin.x + box.size.w > SCREEN_WIDTH ||
+      box.origin.y + box.size.h > SCREEN_HEIGHT) {
+    return NULL;
+  }
 
-     Inputs: ctx    - Pointer to the relevant graphics context.
+  // Pick a free atlas slot, evicting old sprites if the heap is running low:
+  for (i = 0; i < NPC_SPRITE_ATLAS_SIZE; ++i) {
+    if (g_npc_sprites[i].npc_type == NONE) {
+      sprite = &g_npc_sprites[i];
+      break;
+    }
+  }
+  if (sprite == NULL) {
+    sprite = evict_npc_sprite();
+  }
+  while (heap_bytes_free() < (size_t) (box.size.w * box.size.h * 2 +
+                                       NPC_SPRITE_MIN_FREE_HEAP)) {
+    if (evict_npc_sprite() == NULL) {
+      return NULL;
+    }
+  }
+
+  // Save the background, then render the NPC over transparent pixels:
+  background = gbitmap_create_blank(box.size, GBitmapFormat8Bit);
+  if (background == NULL) {
+    return NULL;
+  }
+  background_data = gbitmap_get_data(background);
+  frame_buffer = graphics_capture_frame_buffer(ctx);
+  if (frame_buffer == NULL) {
+    gbitmap_destroy(background);
+    return NULL;
+  }
+  frame_data = gbitmap_get_data(frame_buffer) + box.origin.x;
+  bytes_per_row = gbitmap_get_bytes_per_row(frame_buffer);
+  for (y = box.origin.y; y < box.origin.y + box.size.h; ++y) {
+    memcpy(background_data + (y - box.origin.y) *
+                               gbitmap_get_bytes_per_row(background),
+           frame_data + y * bytes_per_row,
+           box.size.w);
+    memset(frame_data + y * bytes_per_row, GColorClear.argb, box.size.w);
+  }
+  graphics_release_frame_buffer(ctx, frame_buffer);
+  draw_npc(ctx,
+           npc_type,
+           depth,
+           floor_center_point,
+           drawing_unit,
+           NPC_SPRITE_EYE_COLOR);
+
+  // Crop the result to its opaque pixels, then restore the background:
+  frame_buffer = graphics_capture_frame_buffer(ctx);
+  if (frame_buffer == NULL) {
+    gbitmap_destroy(background);
+    return NULL;
+  }
+  frame_data = gbitmap_get_data(frame_buffer) + box.origin.x;
+  min_x = box.size.w;
+  min_y = box.size.h;
+  max_x = max_y = -1;
+  for (y = 0; y < box.size.h; ++y) {
+    for (x = 0; x < box.size.w; ++x) {
+      if (frame_data[(y + box.origin.y) * bytes_per_row + x] !=
+          GColorClear.argb) {
+        if (x < min_x) {
+          min_x = x;
+        }
+        if (x > max_x) {
+          max_x = x;
+        }
+        if (y < min_y) {
+          min_y = y;
+        }
+        max_y = y;
+      }
+    }
+  }
+  if (max_x >= min_x) {
+    sprite->bitmap = gbitmap_create_blank(GSize(max_x - min_x + 1,
+                                                max_y - min_y + 1),
+                                          GBitmapFormat8Bit);
+  }
+  if (sprite->bitmap) {
+    for (y = min_y; y <= max_y; ++y) {
+      memcpy(gbitmap_get_data(sprite->bitmap) +
+               (y - min_y) * gbitmap_get_bytes_per_row(sprite->bitmap),
+             frame_data + (y + box.origin.y) * bytes_per_row + min_x,
+             max_x - min_x + 1);
+    }
+    sprite->npc_type = npc_type;
+    sprite->depth = depth;
+    sprite->frame = frame;
+    sprite->x_offset = box.origin.x + min_x - floor_center_point.x;
+    sprite->y_offset = box.origin.y + min_y - floor_center_point.y;
+  }
+  for (y = 0; y < box.size.h; ++y) {
+    memcpy(frame_data + (y + box.origin.y) * bytes_per_row,
+           background_data + y * gbitmap_get_bytes_per_row(background),
+           box.size.w);
+  }
+  graphics_release_frame_buffer(ctx, frame_buffer);
+  gbitmap_destroy(background);
+
+  return sprite->bitmap ? sprite : NULL;
+}
+
+/*******************************************************************************
+   Function: evict_npc_sprite
+
+Description: Frees the least recently used sprite in the NPC sprite atlas.
+
+     Inputs: None.
+
+    Outputs: Pointer to the freed atlas slot, or NULL if the atlas was empty.
+*******************************************************************************/
+npc_sprite_t *evict_npc_sprite(void) {
+  int8_t i;
+  npc_sprite_t *sprite = NULL;
+
+  for (i = 0; i < NPC_SPRITE_ATLAS_SIZE; ++i) {
+    if (g_npc_sprites[i].npc_type > NONE &&
+        (sprite == NULL ||
+         g_npc_sprites[i].last_used < sprite->last_used)) {
+      sprite = &g_npc_sprites[i];
+    }
+  }
+  if (sprite) {
+    gbitmap_destroy(sprite->bitmap);
+    sprite->bitmap = NULL;
+    sprite->npc_type = NONE;
+  }
+
+  return sprite;
+}
+
+/*******************************************************************************
+   Function: draw_shaded_wall
+
+Description: Draws a shaded wall using the column table precomputed for its
+             depth, position, and side by "init_wall_coords". Each column is
+             written as a single dithered span directly into the frame buffer.
+
+     Inputs: ctx      - Pointer to the relevant graphics context.
+             depth    - Front-back visual depth of the wall's cell in
+                        "g_back_wall_coords".
+             position - Left-right visual position of the wall's cell in
+                        "g_back_wall_coords".
+             side     - BACK_WALL, LEFT_WALL, or RIGHT_WALL.
+
+    Outputs: None.
+*******************************************************************************/
+void draw_shaded_wall(GContext *ctx,
+                      const int8_t depth,
+                      const int8_t position,
+                      const int8_t side) {
+  int16_t i, j;
+  uint16_t bytes_per_row;
+  uint8_t *frame_data, *pixel, color;
+  const wall_quad_t *quad = &g_wall_quads[depth][position][side];
+  const wall_column_t *column = g_wall_columns + quad->first_column;
+  const GColor *colors = g_background_colors[g_location->wall_color_scheme];
+  GBitmap *frame_buffer;
+
+  if (quad->num_columns == 0 ||
+      (frame_buffer = graphics_capture_frame_buffer(ctx)) == NULL) {
+    return;
+  }
+  frame_data = gbitmap_get_data(frame_buffer);
+  bytes_per_row = gbitmap_get_bytes_per_row(frame_buffer);
+
+  for (i = quad->x; i < quad->x + quad->num_columns; ++i, ++column) {
+    // Fill the column with black, then add every "dot_spacing"th point:
+    pixel = frame_data + column->top * bytes_per_row + i;
+    for (j = column->top; j < column->bottom; ++j, pixel += bytes_per_row) {
+      *pixel = GColorBlack.argb;
+    }
+    color = colors[column->color_index].argb;
+    pixel = frame_data + column->first_dot * bytes_per_row + i;
+    for (j = column->first_dot;
+         j < column->bottom;
+         j += column->dot_spacing, pixel += bytes_per_row *
+                                              column->dot_spacing) {
+      *pixel = color;
+    }
+  }
+
+  graphics_release_frame_buffer(ctx, frame_buffer);
+}
+
+/*******************************************************************************
+   Function: draw_status_meter
+
+Description: Draws a "status meter" (such as a "health meter") at a given point
+             according to given max. and current values of the attribute to be
+             represented.
+
+     Inputs: ctx    - Pointer to the relevant graphics context.
              origin - Top-left corner of the status meter.
              ratio  - Ratio of "current value" / "max. value" for the attribute
-                      to be represented.
+                      to be represented, as a fixed-point value.
 
     Outputs: None.
 *******************************************************************************/
 void draw_status_meter(GContext *ctx,
                        GPoint origin,
-                       const float ratio) {
-  uint8_t filled_meter_width = ratio * STATUS_METER_WIDTH;
+                       const fixed_t ratio) {
+  uint8_t filled_meter_width = FIXED_TO_INT(ratio * STATUS_METER_WIDTH);
 
   if (origin.x < SCREEN_CENTER_POINT_X) {  // Health meter:
     graphics_context_set_fill_color(ctx, GColorRed);
@@ -2097,7 +3645,7 @@ void draw_status_meter(GContext *ctx,
                      GCornersAll);
 
   // Now draw the "empty" portion:
-  if (ratio < 1) {
+  if (ratio < FIXED_POINT_ONE) {
     if (origin.x < SCREEN_CENTER_POINT_X) {  // Health meter:
       graphics_context_set_fill_color(ctx, GColorBulgarianRose);
     } else {  // Energy meter:
@@ -2117,7 +3665,10 @@ void draw_status_meter(GContext *ctx,
 /*******************************************************************************
    Function: fill_ellipse
 
-Description: Draws a filled ellipse according to given specifications.
+Description: Draws a filled ellipse according to given specifications, writing
+             one horizontal span per row directly into the frame buffer.
+             (Integer scan conversion: each row's half-width is the largest "x"
+             for which x^2 / h_radius^2 + y^2 / v_radius^2 <= 1.)
 
      Inputs: ctx      - Pointer to the relevant graphics context.
              center   - Central coordinates of the ellipse (with respect to the
@@ -2133,71 +3684,167 @@ void fill_ellipse(GContext *ctx,
                   const uint8_t h_radius,
                   const uint8_t v_radius,
                   const GColor color) {
-  int16_t theta;
-  uint8_t x_offset, y_offset;
+  int16_t x_offset = h_radius, y_offset, y, left, right;
+  uint16_t bytes_per_row;
+  uint8_t *frame_data;
+  const uint32_t h_squared = h_radius * h_radius,
+                 v_squared = v_radius * v_radius;
+  GBitmap *frame_buffer = graphics_capture_frame_buffer(ctx);
+
+  if (frame_buffer == NULL) {
+    return;
+  }
+  frame_data = gbitmap_get_data(frame_buffer);
+  bytes_per_row = gbitmap_get_bytes_per_row(frame_buffer);
+
+  for (y_offset = 0; y_offset <= v_radius; ++y_offset) {
+    // Rows only narrow moving away from the center, so shrink as needed:
+    while (x_offset > 0 &&
+           x_offset * x_offset * v_squared >
+             h_squared * (v_squared - y_offset * y_offset)) {
+      x_offset--;
+    }
+    left = center.x - x_offset < 0 ? 0 : center.x - x_offset;
+    right = center.x + x_offset >= SCREEN_WIDTH ? SCREEN_WIDTH - 1 :
+                                                  center.x + x_offset;
+    if (left > right) {
+      continue;
+    }
 
-  graphics_context_set_stroke_color(ctx, color);
-  for (theta = 0; theta < NINETY_DEGREES; theta += DEFAULT_ROTATION_RATE) {
-    x_offset = cos_lookup(theta) * h_radius / TRIG_MAX_RATIO;
-    y_offset = sin_lookup(theta) * v_radius / TRIG_MAX_RATIO;
-    graphics_draw_line(ctx,
-                       GPoint(center.x - x_offset, center.y - y_offset),
-                       GPoint(center.x + x_offset, center.y - y_offset));
-    graphics_draw_line(ctx,
-                       GPoint(center.x - x_offset, center.y + y_offset),
-                       GPoint(center.x + x_offset, center.y + y_offset));
+    // Fill the row above the center and the one below it:
+    y = center.y - y_offset;
+    if (y >= 0 && y < SCREEN_HEIGHT) {
+      memset(frame_data + y * bytes_per_row + left,
+             color.argb,
+             right - left + 1);
+    }
+    y = center.y + y_offset;
+    if (y_offset > 0 && y >= 0 && y < SCREEN_HEIGHT) {
+      memset(frame_data + y * bytes_per_row + left,
+             color.argb,
+             right - left + 1);
+    }
   }
+
+  graphics_release_frame_buffer(ctx, frame_buffer);
 }
 
 /*******************************************************************************
-   Function: player_spell_timer_callback
+   Function: schedule_animation_frame
+
+Description: Ensures the animation timer is running, so that every active
+             animation (attack slash, player and enemy spells) advances on the
+             next frame. Animations started while the timer is already running
+             simply join in.
+
+     Inputs: None.
 
-Description: Called when the player's spell timer reaches zero.
+    Outputs: None.
+*******************************************************************************/
+void schedule_animation_frame(void) {
+  if (g_animation_timer == NULL) {
+    g_animation_timer = app_timer_register(DEFAULT_TIMER_DURATION,
+                                           animation_timer_callback,
+                                           NULL);
+  }
+}
+
+/*******************************************************************************
+   Function: schedule_idle_work
+
+Description: (Re)starts the idle timer, so that any pending background work
+             (saving, prefetching the next location) waits until the player
+             has pressed no buttons for IDLE_WORK_DELAY milliseconds. Called
+             by every input handler.
+
+     Inputs: None.
+
+    Outputs: None.
+*******************************************************************************/
+void schedule_idle_work(void) {
+  if (g_idle_timer == NULL) {
+    g_idle_timer = app_timer_register(IDLE_WORK_DELAY,
+                                      idle_timer_callback,
+                                      NULL);
+  } else {
+    app_timer_reschedule(g_idle_timer, IDLE_WORK_DELAY);
+  }
+}
+
+/*******************************************************************************
+   Function: idle_timer_callback
+
+Description: Called when the idle timer reaches zero. Does one slice of
+             background work (saving data to persistent storage, else
+             prefetching the next location), then waits for another idle
+             period if anything is left.
 
      Inputs: data - Pointer to additional data (not used).
 
     Outputs: None.
 *******************************************************************************/
-static void player_spell_timer_callback(void *data) {
-  if (--g_player_current_spell_animation > 0) {
-    g_player_spell_timer = app_timer_register(DEFAULT_TIMER_DURATION,
-                                              player_spell_timer_callback,
-                                              NULL);
+static void idle_timer_callback(void *data) {
+  g_idle_timer = NULL;
+#ifdef BENCHMARK_RENDERING
+  if (g_benchmark_map > NONE) {
+    schedule_idle_work();  // "g_location" holds a benchmark map.
+    return;
+  }
+#endif
+  if (g_location_needs_saving) {
+    save_game();
+    g_location_needs_saving = false;
+  } else {
+    prefetch_next_location();
+  }
+  if (g_location_needs_saving ||
+      (g_next_location != NULL && !g_next_location_is_ready)) {
+    schedule_idle_work();
   }
-  layer_mark_dirty(window_get_root_layer(g_windows[GRAPHICS_WINDOW]));
 }
 
 /*******************************************************************************
-   Function: enemy_spell_timer_callback
+   Function: animation_timer_callback
 
-Description: Called when the enemy's spell timer reaches zero.
+Description: Called when the animation timer reaches zero. Advances all active
+             animations together, requests a single redraw for them, and stops
+             the timer once nothing is left to animate.
 
      Inputs: data - Pointer to additional data (not used).
 
     Outputs: None.
 *******************************************************************************/
-static void enemy_spell_timer_callback(void *data) {
-  if (--g_enemy_current_spell_animation > 0) {
-    g_enemy_spell_timer = app_timer_register(DEFAULT_TIMER_DURATION,
-                                             enemy_spell_timer_callback,
-                                             NULL);
+static void animation_timer_callback(void *data) {
+  g_animation_timer = NULL;
+  g_player_is_attacking = false;  // The "attack slash" lasts a single frame.
+  if (g_player_current_spell_animation > 0) {
+    g_player_current_spell_animation--;
   }
-  layer_mark_dirty(window_get_root_layer(g_windows[GRAPHICS_WINDOW]));
+  if (g_enemy_current_spell_animation > 0) {
+    g_enemy_current_spell_animation--;
+  }
+  if (g_player_current_spell_animation > 0 ||
+      g_enemy_current_spell_animation > 0) {
+    schedule_animation_frame();
+  }
+  layer_mark_dirty(g_overlay_layer);
 }
 
+#ifdef BENCHMARK_RENDERING
 /*******************************************************************************
-   Function: attack_timer_callback
+   Function: benchmark_timer_callback
 
-Description: Called when the attack timer reaches zero.
+Description: Called when it's time to draw the next benchmark frame (or, after
+             the benchmark, to redraw the restored scene).
 
      Inputs: data - Pointer to additional data (not used).
 
     Outputs: None.
 *******************************************************************************/
-static void attack_timer_callback(void *data) {
-  g_player_is_attacking = false;
-  layer_mark_dirty(window_get_root_layer(g_windows[GRAPHICS_WINDOW]));
+static void benchmark_timer_callback(void *data) {
+  layer_mark_dirty(g_scene_layer);
 }
+#endif
 
 /*******************************************************************************
    Function: graphics_window_appear
@@ -2212,6 +3859,33 @@ static void graphics_window_appear(Window *window) {
   g_player_current_spell_animation = g_enemy_current_spell_animation = 0;
   g_player_is_attacking = false;
   g_current_window = GRAPHICS_WINDOW;
+  tick_timer_service_subscribe(SECOND_UNIT, tick_handler);
+  schedule_idle_work();
+#ifdef BENCHMARK_RENDERING
+  if (g_benchmark_map == NONE) {
+    start_benchmark();
+  }
+#endif
+}
+
+/*******************************************************************************
+   Function: graphics_window_disappear
+
+Description: Called when the graphics window disappears. Stops the game clock
+             (nothing happens outside active gameplay) and logs power usage
+             counters.
+
+     Inputs: window - Pointer to the graphics window.
+
+    Outputs: None.
+*******************************************************************************/
+static void graphics_window_disappear(Window *window) {
+  tick_timer_service_unsubscribe();
+  APP_LOG(APP_LOG_LEVEL_DEBUG,
+          "%lu ticks handled, %lu redraws skipped, %lu backlight requests",
+          (unsigned long) g_power_counters[TICKS_HANDLED],
+          (unsigned long) g_power_counters[REDRAWS_SKIPPED],
+          (unsigned long) g_power_counters[BACKLIGHT_REQUESTS]);
 }
 
 /*******************************************************************************
@@ -2240,6 +3914,7 @@ Description: The graphics window's single repeating click handler for the "up"
 *******************************************************************************/
 void graphics_up_single_repeating_click(ClickRecognizerRef recognizer,
                                         void *context) {
+  schedule_idle_work();
   if (g_current_window == GRAPHICS_WINDOW) {
     move_player(g_player->direction);
   }
@@ -2257,8 +3932,9 @@ Description: The graphics window's multi-click handler for the "up" button.
     Outputs: None.
 *******************************************************************************/
 void graphics_up_multi_click(ClickRecognizerRef recognizer, void *context) {
+  schedule_idle_work();
   if (g_current_window == GRAPHICS_WINDOW) {
-    set_player_direction(get_direction_to_the_left(g_player->direction));
+    set_player_direction(g_directions_to_the_left[g_player->direction]);
   }
 }
 
@@ -2275,8 +3951,9 @@ Description: The graphics window's single repeating click handler for the "down"
 *******************************************************************************/
 void graphics_down_single_repeating_click(ClickRecognizerRef recognizer,
                                           void *context) {
+  schedule_idle_work();
   if (g_current_window == GRAPHICS_WINDOW) {
-    move_player(get_opposite_direction(g_player->direction));
+    move_player(g_opposite_directions[g_player->direction]);
   }
 }
 
@@ -2292,8 +3969,9 @@ Description: The graphics window's multi-click handler for the "down" button.
     Outputs: None.
 *******************************************************************************/
 void graphics_down_multi_click(ClickRecognizerRef recognizer, void *context) {
+  schedule_idle_work();
   if (g_current_window == GRAPHICS_WINDOW) {
-    set_player_direction(get_direction_to_the_right(g_player->direction));
+    set_player_direction(g_directions_to_the_right[g_player->direction]);
   }
 }
 
@@ -2316,6 +3994,7 @@ void graphics_select_single_repeating_click(ClickRecognizerRef recognizer,
   npc_t *npc = NULL;
   heavy_item_t *weapon = get_heavy_item_equipped_at(RIGHT_HAND);
 
+  schedule_idle_work();
   if (g_current_window == GRAPHICS_WINDOW &&
       g_player->int16_stats[CURRENT_ENERGY] >=
         g_player->int8_stats[FATIGUE_RATE]) {
@@ -2336,9 +4015,7 @@ void graphics_select_single_repeating_click(ClickRecognizerRef recognizer,
     // If a Pebble is equipped, cast a spell:
     if (g_player->equipped_pebble > NONE) {
       g_player_current_spell_animation = NUM_SPELL_ANIMATIONS;
-      g_player_spell_timer = app_timer_register(DEFAULT_TIMER_DURATION,
-                                                player_spell_timer_callback,
-                                                NULL);
+      schedule_animation_frame();
       cast_spell_on_npc(npc,
                         g_player->equipped_pebble,
                         g_player->int8_stats[MAGICAL_POWER]);
@@ -2356,8 +4033,9 @@ void graphics_select_single_repeating_click(ClickRecognizerRef recognizer,
         if (npc &&
             rand() % g_player->int8_stats[PHYSICAL_POWER] >
               rand() % npc->physical_defense) {
-          npc->status_effects[weapon->type % 2 ? DAMAGE_OVER_TIME : STUN] +=
-            damage;
+          add_npc_status_effect(npc,
+                                weapon->type % 2 ? DAMAGE_OVER_TIME : STUN,
+                                damage);
         }
 
         // Check for an infused Pebble:
@@ -2378,12 +4056,10 @@ void graphics_select_single_repeating_click(ClickRecognizerRef recognizer,
                             STATUS_BAR_HEIGHT;
       g_attack_slash_y2 = GRAPHICS_FRAME_HEIGHT - STATUS_BAR_HEIGHT -
                             rand() % (GRAPHICS_FRAME_HEIGHT / 3);
-      g_attack_timer = app_timer_register(DEFAULT_TIMER_DURATION,
-                                          attack_timer_callback,
-                                          NULL);
+      schedule_animation_frame();
     }
 
-    layer_mark_dirty(window_get_root_layer(g_windows[GRAPHICS_WINDOW]));
+    layer_mark_dirty(g_scene_layer);
   }
 }
 
@@ -2437,6 +4113,7 @@ Description: The narration window's single-click handler for all buttons. Shows
     Outputs: None.
 *******************************************************************************/
 void narration_single_click(ClickRecognizerRef recognizer, void *context) {
+  schedule_idle_work();
   if (g_current_narration < INTRO_NARRATION_4) {
     show_narration(++g_current_narration);
   } else {
@@ -2473,102 +4150,89 @@ Description: Handles changes to the game world every second while in active
 *******************************************************************************/
 static void tick_handler(struct tm *tick_time, TimeUnits units_changed) {
   int8_t i,
-         j,
          diff_x,
          diff_y,
-         horizontal_direction,
-         vertical_direction,
+         movement_direction,
          direction = rand() % NUM_DIRECTIONS;
   int16_t damage;
   npc_t *npc;
   GPoint cell;
-  bool player_is_visible_to_npc = false;
 
+#ifdef BENCHMARK_RENDERING
+  if (g_benchmark_map > NONE) {
+    return;  // Keep NPCs still while benchmarking.
+  }
+#endif
   if (g_current_window == GRAPHICS_WINDOW) {
-    // Handle NPC behavior:
-    for (i = 0; i < MAX_NPCS_AT_ONE_TIME; ++i) {
-      npc = &g_location->npcs[i];
-      if (npc->type > NONE) {
-        if (npc->status_effects[STUN] == 0 &&
-            npc->status_effects[SLOW] % 2 == 0) {
-          damage = rand() % npc->power - npc->status_effects[WEAKNESS] / 2;
-          diff_x = npc->position.x - g_player->position.x;
-          diff_y = npc->position.y - g_player->position.y;
-
-          // Determine whether the NPC can "see" the player:
-          if (diff_x == 0 || diff_y == 0) {
-            j = 0;
-            cell = npc->position;
-            horizontal_direction = diff_x > 0 ? WEST : EAST;
-            vertical_direction = diff_y > 0 ? NORTH : SOUTH;
-            do {
-              cell = get_cell_farther_away(cell,
-                                           diff_x == 0 ? vertical_direction :
-                                                         horizontal_direction,
-                                           1);
-              if (gpoint_equal(&g_player->position, &cell)) {
-                player_is_visible_to_npc = true;
-                break;
-              }
-            }while (occupiable(cell) && ++j < (MAX_VISIBILITY_DEPTH - 2));
+    // Handle NPC behavior (live NPCs only, last to first so that removals
+    // along the way can't cause any to be skipped):
+    for (i = g_location->num_active_npcs - 1; i >= 0; --i) {
+      npc = &g_location->npcs[g_location->active_npcs[i]];
+      if (get_npc_status_effect(npc, STUN) == 0 &&
+          get_npc_status_effect(npc, SLOW) % 2 == 0) {
+        damage = rand() % npc->power -
+                   get_npc_status_effect(npc, WEAKNESS) / 2;
+        diff_x = npc->position.x - g_player->position.x;
+        diff_y = npc->position.y - g_player->position.y;
+
+        if (get_npc_status_effect(npc, INTIMIDATION)) {
+          movement_direction = get_distance_field_direction(npc->position,
+                                                            true);
+          if (movement_direction != NONE) {
+            move_npc(npc, movement_direction);
           }
-
-          if (npc->status_effects[INTIMIDATION]) {
-            move_npc(npc,
-                    get_opposite_direction(get_pursuit_direction(npc->position,
-                                                          g_player->position)));
-          } else if (npc->type == MAGE && player_is_visible_to_npc) {
-            g_enemy_current_spell_animation = NUM_SPELL_ANIMATIONS;
-            g_enemy_spell_timer = app_timer_register(DEFAULT_TIMER_DURATION,
-                                                     enemy_spell_timer_callback,
-                                                     NULL);
-            if (g_player->int8_stats[SHADOW_FORM] &&
-                (rand() % g_player->int8_stats[INTELLECT] +
-                   g_player->int8_stats[SHADOW_FORM] > damage)) {
-              adjust_player_current_health(damage / 2 + 1);
-              adjust_player_current_energy(damage / 2 + 1);
-            } else {
-              damage_player(damage -
-                              rand() % g_player->int8_stats[MAGICAL_DEFENSE]);
-            }
-          } else if ((diff_x == 0 && abs(diff_y) == 1) ||
-                     (diff_y == 0 && abs(diff_x) == 1)) {
-            damage_player(damage -
-                            rand() % g_player->int8_stats[PHYSICAL_DEFENSE]);
-            if (g_player->int8_stats[BACKLASH_DAMAGE]) {
-              damage_npc(npc,
-                         damage / (rand() % npc->magical_defense + 1) +
-                           g_player->int8_stats[BACKLASH_DAMAGE]);
-            }
+        } else if (npc->type == MAGE &&
+                   in_line_of_sight(npc->position, g_player->position)) {
+          g_enemy_current_spell_animation = NUM_SPELL_ANIMATIONS;
+          g_enemy_spell_caster = npc - g_location->npcs;
+          schedule_animation_frame();
+          if (g_player->int8_stats[SHADOW_FORM] &&
+              (rand() % g_player->int8_stats[INTELLECT] +
+                 g_player->int8_stats[SHADOW_FORM] > damage)) {
+            adjust_player_current_health(damage / 2 + 1);
+            adjust_player_current_energy(damage / 2 + 1);
           } else {
-            move_npc(npc,
-                     get_pursuit_direction(npc->position, g_player->position));
+            damage_player(damage -
+                            rand() % g_player->int8_stats[MAGICAL_DEFENSE]);
+          }
+        } else if ((diff_x == 0 && abs(diff_y) == 1) ||
+                   (diff_y == 0 && abs(diff_x) == 1)) {
+          damage_player(damage -
+                          rand() % g_player->int8_stats[PHYSICAL_DEFENSE]);
+          if (g_player->int8_stats[BACKLASH_DAMAGE]) {
+            damage_npc(npc,
+                       damage / (rand() % npc->magical_defense + 1) +
+                         g_player->int8_stats[BACKLASH_DAMAGE]);
+          }
+        } else {
+          movement_direction = get_distance_field_direction(npc->position,
+                                                            false);
+          if (movement_direction != NONE) {
+            move_npc(npc, movement_direction);
           }
         }
+      }
 
-        // Check for player death:
-        if (g_player->int16_stats[CURRENT_HEALTH] <= 0) {
-          show_window(MAIN_MENU, NOT_ANIMATED);
-          show_window(STATS_MENU, NOT_ANIMATED);
-          show_narration(DEATH_NARRATION);
-          return;
-        }
-
-        // Apply wounding/burning damage:
-        if (npc->status_effects[DAMAGE_OVER_TIME]) {
-          damage_npc(npc, npc->status_effects[DAMAGE_OVER_TIME] / 2);
-        }
+      // Check for player death:
+      if (g_player->int16_stats[CURRENT_HEALTH] <= 0) {
+        show_window(MAIN_MENU, NOT_ANIMATED);
+        show_window(STATS_MENU, NOT_ANIMATED);
+        show_narration(DEATH_NARRATION);
+        return;
+      }
 
-        // Reduce all status effects:
-        for (j = 0; j < NUM_STATUS_EFFECTS; ++j) {
-          if (npc->status_effects[j] > 0) {
-            npc->status_effects[j]--;
-          }
-        }
+      // Apply wounding/burning damage (unless backlash has killed the NPC):
+      if (npc->type > NONE && get_npc_status_effect(npc, DAMAGE_OVER_TIME)) {
+        damage_npc(npc, get_npc_status_effect(npc, DAMAGE_OVER_TIME) / 2);
       }
     }
 
-    // Generate new NPCs periodically (does nothing if the NPC array is full):
+    // Advance the clock against which status effects expire:
+    if (++g_location->tick_count % STATUS_EFFECT_SWEEP_INTERVAL == 0) {
+      sweep_npc_status_effects();
+    }
+
+    // Generate new NPCs periodically (does nothing if the NPC pool is full):
     if (rand() % 9 == 0) {
       // Attempt to find a viable spawn point:
       for (i = 0; i < NUM_DIRECTIONS; ++i) {
@@ -2591,7 +4255,16 @@ static void tick_handler(struct tm *tick_time, TimeUnits units_changed) {
     adjust_player_current_health(g_player->int8_stats[HEALTH_REGEN]);
     adjust_player_current_energy(g_player->int8_stats[ENERGY_REGEN]);
 
-    layer_mark_dirty(window_get_root_layer(g_windows[GRAPHICS_WINDOW]));
+    // Redraw only if something visible has changed:
+    g_power_counters[TICKS_HANDLED]++;
+    if (g_scene_is_cached &&
+        get_scene_hash() == g_scene_hash &&
+        get_overlay_hash() == g_overlay_hash) {
+      g_power_counters[REDRAWS_SKIPPED]++;
+      keep_backlight_on();
+    } else {
+      layer_mark_dirty(g_scene_layer);
+    }
   }
 }
 
@@ -2727,325 +4400,1144 @@ void set_player_minor_stats(void) {
     }
   }
 
-  // Armor/Robe:
-  heavy_item = get_heavy_item_equipped_at(BODY);
-  if (heavy_item) {
-    for (i = LIGHT_ARMOR; i <= heavy_item->type; ++i) {
-      g_player->int8_stats[PHYSICAL_DEFENSE] += DEFAULT_ITEM_BONUS;
-      g_player->int8_stats[MAGICAL_POWER]--;
-      g_player->int8_stats[FATIGUE_RATE]++;
+  // Armor/Robe:
+  heavy_item = get_heavy_item_equipped_at(BODY);
+  if (heavy_item) {
+    for (i = LIGHT_ARMOR; i <= heavy_item->type; ++i) {
+      g_player->int8_stats[PHYSICAL_DEFENSE] += DEFAULT_ITEM_BONUS;
+      g_player->int8_stats[MAGICAL_POWER]--;
+      g_player->int8_stats[FATIGUE_RATE]++;
+    }
+    if (heavy_item->infused_pebble == PEBBLE_OF_SHADOW) {
+      g_player->int8_stats[PHYSICAL_DEFENSE]++;
+    }
+  }
+
+  // Shield:
+  heavy_item = get_heavy_item_equipped_at(LEFT_HAND);
+  if (heavy_item) {
+    g_player->int8_stats[PHYSICAL_DEFENSE] += DEFAULT_ITEM_BONUS;
+    g_player->int8_stats[MAGICAL_POWER]--;
+    g_player->int8_stats[FATIGUE_RATE]++;
+    if (heavy_item->infused_pebble == PEBBLE_OF_SHADOW) {
+      g_player->int8_stats[PHYSICAL_DEFENSE]++;
+    }
+  }
+
+  // Ensure magical power doesn't fall too low:
+  if (g_player->int8_stats[MAGICAL_POWER] < DEFAULT_MAJOR_STAT_VALUE) {
+    g_player->int8_stats[MAGICAL_POWER] = DEFAULT_MAJOR_STAT_VALUE;
+  }
+}
+
+/*******************************************************************************
+   Function: init_player
+
+Description: Initializes the global player struct according to default values.
+
+     Inputs: None.
+
+    Outputs: None.
+*******************************************************************************/
+void init_player(void) {
+  int8_t i;
+
+  // Set major stats (attributes), etc.:
+  for (i = FIRST_MAJOR_STAT; i < NUM_MAJOR_STATS + FIRST_MAJOR_STAT; ++i) {
+    g_player->int8_stats[i] = DEFAULT_MAJOR_STAT_VALUE;
+  }
+  g_player->int8_stats[LEVEL] =
+    g_player->int8_stats[HEALTH_REGEN] =
+    g_player->int8_stats[ENERGY_REGEN] = 1;
+  g_player->exp_points =  // 58806 to reach max. level!
+    g_player->int8_stats[DEPTH] =
+    g_player->int8_stats[BACKLASH_DAMAGE] =
+    g_player->int8_stats[SHADOW_FORM] = 0;
+  g_next_location_is_ready = false;  // It was generated for the old depth.
+
+  // Assign starting inventory:
+  for (i = 0; i < NUM_PEBBLE_TYPES; ++i) {
+    g_player->pebbles[i] = 0;
+  }
+  g_player->equipped_pebble = NONE;
+  for (i = 1; i < MAX_HEAVY_ITEMS; ++i) {
+    init_heavy_item(&g_player->heavy_items[i], NONE);
+  }
+  init_heavy_item(&g_player->heavy_items[0], ROBE);
+
+  // Equip the robe, causing all minor stats to be set:
+  equip_heavy_item(&g_player->heavy_items[0]);
+
+  // Finally, ensure health and energy are at 100%:
+  g_player->int16_stats[CURRENT_HEALTH] = g_player->int16_stats[MAX_HEALTH];
+  g_player->int16_stats[CURRENT_ENERGY] = g_player->int16_stats[MAX_ENERGY];
+}
+
+/*******************************************************************************
+   Function: init_npc
+
+Description: Initializes a given non-player character (NPC) struct of the
+             current location according to a given NPC type and starting
+             position, keeping the NPC occupancy grid up to date.
+
+     Inputs: npc      - Pointer to the NPC struct to be initialized.
+             type     - Integer indicating the desired NPC type.
+             position - The NPC's starting position.
+
+    Outputs: None.
+*******************************************************************************/
+void init_npc(npc_t *const npc, const int8_t type, const GPoint position) {
+  if (npc->type > NONE) {
+    g_npc_grid[npc->position.x][npc->position.y] = NONE;
+  }
+  init_npc_struct(npc, type, position, g_location->tick_count);
+  g_npc_grid[position.x][position.y] = npc - g_location->npcs;
+}
+
+/*******************************************************************************
+   Function: init_npc_struct
+
+Description: Initializes a given NPC struct, of any location, according to a
+             given NPC type and starting position (see "init_npc").
+
+     Inputs: npc        - Pointer to the NPC struct to be initialized.
+             type       - Integer indicating the desired NPC type.
+             position   - The NPC's starting position.
+             tick_count - The location's tick count (status effects start out
+                          expiring then).
+
+    Outputs: None.
+*******************************************************************************/
+void init_npc_struct(npc_t *const npc,
+                     const int8_t type,
+                     const GPoint position,
+                     const uint32_t tick_count) {
+  int8_t i;
+
+  npc->type = type;
+  npc->position = position;
+  npc->item = NONE;
+  for (i = 0; i < NUM_STATUS_EFFECTS; ++i) {
+    npc->status_effect_expiry_ticks[i] = tick_count;
+  }
+
+  // Set stats according to current dungeon depth:
+  npc->health = npc->power = npc->physical_defense = npc->magical_defense =
+    1 + g_player->int8_stats[DEPTH] - g_player->int8_stats[DEPTH] / 2;
+
+  // Check for increased power:
+  if (type <= WHITE_MONSTER_MEDIUM ||
+      type == WARRIOR_MEDIUM ||
+      type == WARRIOR_LARGE ||
+      (type >= DARK_OGRE && type <= PALE_TROLL)) {
+    npc->power++;
+  }
+  if (type <= WHITE_MONSTER_LARGE ||
+      type == WARRIOR_LARGE ||
+      type == DARK_OGRE ||
+      type == PALE_OGRE) {
+    npc->power++;
+  }
+
+  // Check for increased/decreased defenses:
+  if (type == MAGE || (type < WARRIOR_LARGE && type % 2)) {
+    npc->magical_defense++;
+    if (npc->physical_defense > 1) {  // It's a divisor in physical attacks.
+      npc->physical_defense--;
+    }
+  } else if (type >= WARRIOR_LARGE) {
+    npc->physical_defense++;
+  }
+
+  // Some NPCs may carry a random item:
+  if (type > WHITE_MONSTER_SMALL) {
+    npc->item = rand() % 2 ? NONE : RANDOM_ITEM;  // Excludes Pebbles.
+  }
+
+  // Mages are the only source of Pebbles:
+  if (type == MAGE) {
+    npc->item = rand() % NUM_PEBBLE_TYPES;
+  }
+}
+
+/*******************************************************************************
+   Function: init_heavy_item
+
+Description: Initializes a new heavy item struct according to a given type.
+
+     Inputs: item - Pointer to the heavy item struct.
+             type - The type of heavy item to be initialized.
+
+    Outputs: None.
+*******************************************************************************/
+void init_heavy_item(heavy_item_t *const item, const int8_t type) {
+  item->type = type;
+  item->infused_pebble = NONE;
+  item->equipped = false;
+  if (type < SHIELD) {
+    item->equip_target = RIGHT_HAND;
+  } else if (type == SHIELD) {
+    item->equip_target = LEFT_HAND;
+  } else {
+    item->equip_target = BODY;
+  }
+}
+
+/*******************************************************************************
+   Function: init_wall_coords
+
+Description: Initializes the global "back_wall_coords" array so it contains the
+             top-left and bottom-right coordinates for every potential back wall
+             location on the screen. (This establishes the field of view and
+             sense of perspective while also facilitating convenient drawing of
+             the 3D environment.) Also builds the column tables used to draw
+             every potential back, left, and right wall (if there's no room
+             for them, every wall is left with no columns, so none is drawn).
+
+     Inputs: None.
+
+    Outputs: None.
+*******************************************************************************/
+void init_wall_coords(void) {
+  uint8_t i, j, side, wall_width;
+  uint16_t num_columns;
+  const uint8_t perspective_modifier = 2;  // Helps determine FOV, etc.
+  wall_quad_t *quad;
+  GPoint upper_left, lower_left, upper_right;
+
+  for (i = 0; i < MAX_VISIBILITY_DEPTH - 1; ++i) {
+    for (j = 0; j < (STRAIGHT_AHEAD * 2) + 1; ++j) {
+      g_back_wall_coords[i][j][TOP_LEFT] = GPoint(0, 0);
+      g_back_wall_coords[i][j][BOTTOM_RIGHT] = GPoint(0, 0);
+    }
+  }
+  for (i = 0; i < MAX_VISIBILITY_DEPTH - 1; ++i) {
+    g_back_wall_coords[i][STRAIGHT_AHEAD][TOP_LEFT] =
+      GPoint(FIRST_WALL_OFFSET - i * perspective_modifier,
+             FIRST_WALL_OFFSET - i * perspective_modifier);
+    if (i > 0) {
+      g_back_wall_coords[i][STRAIGHT_AHEAD][TOP_LEFT].x +=
+        g_back_wall_coords[i - 1][STRAIGHT_AHEAD][TOP_LEFT].x;
+      g_back_wall_coords[i][STRAIGHT_AHEAD][TOP_LEFT].y +=
+        g_back_wall_coords[i - 1][STRAIGHT_AHEAD][TOP_LEFT].y;
+    }
+    g_back_wall_coords[i][STRAIGHT_AHEAD][BOTTOM_RIGHT].x =
+      GRAPHICS_FRAME_WIDTH - g_back_wall_coords[i][STRAIGHT_AHEAD][TOP_LEFT].x;
+    g_back_wall_coords[i][STRAIGHT_AHEAD][BOTTOM_RIGHT].y =
+      GRAPHICS_FRAME_HEIGHT -
+        g_back_wall_coords[i][STRAIGHT_AHEAD][TOP_LEFT].y;
+    wall_width = g_back_wall_coords[i][STRAIGHT_AHEAD][BOTTOM_RIGHT].x -
+                   g_back_wall_coords[i][STRAIGHT_AHEAD][TOP_LEFT].x;
+    for (j = 1; j <= STRAIGHT_AHEAD; ++j) {
+      g_back_wall_coords[i][STRAIGHT_AHEAD - j][TOP_LEFT] =
+        g_back_wall_coords[i][STRAIGHT_AHEAD][TOP_LEFT];
+      g_back_wall_coords[i][STRAIGHT_AHEAD - j][TOP_LEFT].x -= wall_width * j;
+      g_back_wall_coords[i][STRAIGHT_AHEAD - j][BOTTOM_RIGHT] =
+        g_back_wall_coords[i][STRAIGHT_AHEAD][BOTTOM_RIGHT];
+      g_back_wall_coords[i][STRAIGHT_AHEAD - j][BOTTOM_RIGHT].x -= wall_width *
+                                                                     j;
+      g_back_wall_coords[i][STRAIGHT_AHEAD + j][TOP_LEFT] =
+        g_back_wall_coords[i][STRAIGHT_AHEAD][TOP_LEFT];
+      g_back_wall_coords[i][STRAIGHT_AHEAD + j][TOP_LEFT].x += wall_width * j;
+      g_back_wall_coords[i][STRAIGHT_AHEAD + j][BOTTOM_RIGHT] =
+        g_back_wall_coords[i][STRAIGHT_AHEAD][BOTTOM_RIGHT];
+      g_back_wall_coords[i][STRAIGHT_AHEAD + j][BOTTOM_RIGHT].x += wall_width *
+                                                                     j;
+    }
+  }
+
+  // Lay out on-screen columns for every potential wall, then shade them:
+  num_columns = 0;
+  for (i = 0; i < MAX_VISIBILITY_DEPTH - 1; ++i) {
+    for (j = 0; j < (STRAIGHT_AHEAD * 2) + 1; ++j) {
+      for (side = 0; side < NUM_WALL_SIDES; ++side) {
+        quad = &g_wall_quads[i][j][side];
+        quad->num_columns = 0;
+        quad->first_column = num_columns;
+        if (get_wall_corners(i, j, side, &upper_left, &lower_left,
+                             &upper_right)) {
+          quad->x = upper_left.x < 0 ? 0 : upper_left.x;
+          if (upper_right.x >= quad->x && quad->x < GRAPHICS_FRAME_WIDTH) {
+            quad->num_columns = (upper_right.x < GRAPHICS_FRAME_WIDTH ?
+                                   upper_right.x                       :
+                                   GRAPHICS_FRAME_WIDTH - 1) - quad->x + 1;
+          }
+        }
+        num_columns += quad->num_columns;
+      }
+    }
+  }
+  g_wall_columns = malloc(num_columns * sizeof(wall_column_t));
+  for (i = 0; i < MAX_VISIBILITY_DEPTH - 1; ++i) {
+    for (j = 0; j < (STRAIGHT_AHEAD * 2) + 1; ++j) {
+      for (side = 0; side < NUM_WALL_SIDES; ++side) {
+        quad = &g_wall_quads[i][j][side];
+        if (g_wall_columns == NULL) {
+          quad->num_columns = 0;  // Out of memory, so no walls are drawn.
+        } else if (quad->num_columns > 0) {
+          get_wall_corners(i, j, side, &upper_left, &lower_left, &upper_right);
+          init_wall_columns(quad, upper_left, lower_left, upper_right);
+        }
+      }
+    }
+  }
+}
+
+/*******************************************************************************
+   Function: get_wall_corners
+
+Description: Determines the upper-left, lower-left, and upper-right screen
+             coordinates of a potential wall. (Left and right sides are always
+             parallel, so the lower-right point is implied.)
+
+     Inputs: depth       - Front-back visual depth of the wall's cell in
+                           "g_back_wall_coords".
+             position    - Left-right visual position of the wall's cell in
+                           "g_back_wall_coords".
+             side        - BACK_WALL, LEFT_WALL, or RIGHT_WALL.
+             upper_left  - Pointer to be given the upper-left coordinates.
+             lower_left  - Pointer to be given the lower-left coordinates.
+             upper_right - Pointer to be given the upper-right coordinates.
+
+    Outputs: "True" if such a wall may ever be drawn.
+*******************************************************************************/
+bool get_wall_corners(const int8_t depth,
+                      const int8_t position,
+                      const int8_t side,
+                      GPoint *const upper_left,
+                      GPoint *const lower_left,
+                      GPoint *const upper_right) {
+  int16_t left, right, top, bottom, y_offset;
+
+  left = g_back_wall_coords[depth][position][TOP_LEFT].x;
+  right = g_back_wall_coords[depth][position][BOTTOM_RIGHT].x;
+  top = g_back_wall_coords[depth][position][TOP_LEFT].y + STATUS_BAR_HEIGHT;
+  bottom = g_back_wall_coords[depth][position][BOTTOM_RIGHT].y +
+             STATUS_BAR_HEIGHT;
+  if (bottom - top < MIN_WALL_HEIGHT) {
+    return false;
+  }
+  if (depth == 0) {
+    y_offset = top - STATUS_BAR_HEIGHT;
+  } else {
+    y_offset = top - STATUS_BAR_HEIGHT -
+                 g_back_wall_coords[depth - 1][position][TOP_LEFT].y;
+  }
+
+  if (side == BACK_WALL) {
+    *upper_left = GPoint(left, top);
+    *lower_left = GPoint(left, bottom);
+    *upper_right = GPoint(right, top);
+  } else if (side == LEFT_WALL) {
+    if (position > STRAIGHT_AHEAD) {
+      return false;
+    }
+    right = left;
+    left = depth == 0 ? 0 : g_back_wall_coords[depth - 1][position][TOP_LEFT].x;
+    *upper_left = GPoint(left, top - y_offset);
+    *lower_left = GPoint(left, bottom + y_offset);
+    *upper_right = GPoint(right, top);
+  } else {  // if (side == RIGHT_WALL)
+    if (position < STRAIGHT_AHEAD) {
+      return false;
+    }
+    left = right;
+    right = depth == 0 ? GRAPHICS_FRAME_WIDTH - 1 :
+                         g_back_wall_coords[depth - 1][position][BOTTOM_RIGHT].x;
+    *upper_left = GPoint(left, top);
+    *lower_left = GPoint(left, bottom);
+    *upper_right = GPoint(right, top - y_offset);
+  }
+
+  return true;
+}
+
+/*******************************************************************************
+   Function: init_wall_columns
+
+Description: Fills in the column table of a given wall quad: the top and bottom
+             of each on-screen column along with the row, spacing, and color
+             index of its shading dots.
+
+     Inputs: quad        - Pointer to the wall quad whose columns are to be
+                           initialized.
+             upper_left  - Upper-left coordinates of the wall.
+             lower_left  - Lower-left coordinates of the wall.
+             upper_right - Upper-right coordinates of the wall.
+
+    Outputs: None.
+*******************************************************************************/
+void init_wall_columns(const wall_quad_t *const quad,
+                       const GPoint upper_left,
+                       const GPoint lower_left,
+                       const GPoint upper_right) {
+  int16_t i, shading_offset, half_shading_offset, top, bottom, phase;
+  const int16_t dx = upper_right.x - upper_left.x,
+                dy = upper_right.y - upper_left.y;
+  fixed_t y_offset, y;
+  wall_column_t *column = g_wall_columns + quad->first_column;
+
+  for (i = quad->x; i < quad->x + quad->num_columns; ++i, ++column) {
+    // Multiply before dividing so whole-pixel offsets stay exact:
+    y_offset = INT_TO_FIXED((i - upper_left.x) * dy) / dx;
+    y        = INT_TO_FIXED(upper_left.y) + y_offset;
+
+    // Determine vertical distance between points:
+    shading_offset = 1 + FIXED_TO_INT(y) / MAX_VISIBILITY_DEPTH;
+    if (FIXED_TO_INT(y) % MAX_VISIBILITY_DEPTH >= MAX_VISIBILITY_DEPTH / 2 +
+                                                  MAX_VISIBILITY_DEPTH % 2) {
+      shading_offset++;
+    }
+    half_shading_offset = (shading_offset / 2) + (shading_offset % 2);
+    if (shading_offset - 3 > NUM_BACKGROUND_COLORS_PER_SCHEME) {
+      column->color_index = NUM_BACKGROUND_COLORS_PER_SCHEME - 1;
+    } else if (shading_offset > 4) {
+      column->color_index = shading_offset - 4;
+    } else {
+      column->color_index = 0;
+    }
+
+    // Determine the column's span (rounding the bottom up):
+    top    = FIXED_TO_INT(y);
+    bottom = FIXED_TO_INT(INT_TO_FIXED(lower_left.y) - y_offset +
+                          FIXED_POINT_ONE - 1);
+    if (top < 0) {
+      top = 0;
+    }
+    if (bottom > SCREEN_HEIGHT) {
+      bottom = SCREEN_HEIGHT;
+    }
+    column->top = top;
+    column->bottom = bottom;
+
+    // Determine the first shading dot (every "shading_offset"th point):
+    phase = (FIXED_TO_INT(y_offset) +
+             (i % 2 == 0 ? 0 : half_shading_offset) + top) % shading_offset;
+    if (phase < 0) {
+      phase += shading_offset;
+    }
+    column->first_dot = top + (phase == 0 ? 0 : shading_offset - phase);
+    column->dot_spacing = shading_offset;
+  }
+}
+
+/*******************************************************************************
+   Function: init_floor_and_ceiling_bitmap
+
+Description: Renders the ceiling's dot pattern for the current floor color
+             scheme into the global floor and ceiling bitmap (one row per row
+             of ceiling, from the top of the graphics frame downward). The floor
+             is drawn from the same rows, mirrored vertically.
+
+     Inputs: None.
+
+    Outputs: None.
+*******************************************************************************/
+void init_floor_and_ceiling_bitmap(void) {
+  uint8_t x, y, max_y, shading_offset, *row;
+  GColor color;
+
+  if (g_floor_and_ceiling_bitmap == NULL) {
+    return;
+  }
+  max_y = g_back_wall_coords[MAX_VISIBILITY_DEPTH - 2][0][TOP_LEFT].y;
+  for (y = 0; y < max_y; ++y) {
+    row = gbitmap_get_data(g_floor_and_ceiling_bitmap) +
+            y * gbitmap_get_bytes_per_row(g_floor_and_ceiling_bitmap);
+    memset(row, GColorBlack.argb, GRAPHICS_FRAME_WIDTH);
+
+    // Determine horizontal distance between points:
+    shading_offset = 1 + y / MAX_VISIBILITY_DEPTH;
+    if (y % MAX_VISIBILITY_DEPTH >= MAX_VISIBILITY_DEPTH / 2 +
+                                    MAX_VISIBILITY_DEPTH % 2) {
+      shading_offset++;
+    }
+    color = g_background_colors[g_location->floor_color_scheme]
+                               [shading_offset >
+                                  NUM_BACKGROUND_COLORS_PER_SCHEME ?
+                                  NUM_BACKGROUND_COLORS_PER_SCHEME - 1 :
+                                  shading_offset - 1];
+    for (x = y % 2 ? 0 : (shading_offset / 2) + (shading_offset % 2);
+         x < GRAPHICS_FRAME_WIDTH;
+         x += shading_offset) {
+      row[x] = color.argb;
+    }
+  }
+  g_floor_and_ceiling_color_scheme = g_location->floor_color_scheme;
+}
+
+/*******************************************************************************
+   Function: carve_cell
+
+Description: Opens up a solid cell of a given location, adding random loot (1
+             in LOOT_CHANCE, never at the entrance) or else making it EMPTY.
+             Cells that are already open, including exits, are left as is.
+
+     Inputs: location - Pointer to the location being generated.
+             cell     - Coordinates of the cell of interest (in-bounds).
+
+    Outputs: None.
+*******************************************************************************/
+void carve_cell(location_t *const location, const GPoint cell) {
+  if (get_terrain(location, cell) != SOLID_TERRAIN) {
+    return;
+  }
+  if (rand() % LOOT_CHANCE == 0 &&
+      !gpoint_equal(&cell, &location->entrance)) {
+    set_location_cell_type(location, cell, RANDOM_ITEM);  // Excl. Pebbles.
+  } else {
+    set_location_cell_type(location, cell, EMPTY);
+  }
+}
+
+/*******************************************************************************
+   Function: carve_corridor
+
+Description: Carves an L-shaped corridor between two cells (inclusive), moving
+             along a randomly chosen axis first.
+
+     Inputs: location - Pointer to the location being generated.
+             from     - Coordinates of the corridor's first cell.
+             to       - Coordinates of its last cell.
+
+    Outputs: None.
+*******************************************************************************/
+void carve_corridor(location_t *const location,
+                    GPoint from,
+                    const GPoint to) {
+  const bool horizontal_first = rand() % 2;
+
+  carve_cell(location, from);
+  while (!gpoint_equal(&from, &to)) {
+    if (from.x != to.x && (horizontal_first || from.y == to.y)) {
+      from.x += (to.x > from.x) - (to.x < from.x);
+    } else {
+      from.y += (to.y > from.y) - (to.y < from.y);
+    }
+    carve_cell(location, from);
+  }
+}
+
+/*******************************************************************************
+   Function: carve_winding_path
+
+Description: Carves a winding path from a given location's entrance to its
+             exit. In each row (or column), the builder walks sideways to up to
+             BUILDER_TURNS_PER_ROW randomly chosen cells, then steps one row
+             closer to the exit's edge, so the path can't take more than about
+             2 * MAP_WIDTH * MAP_HEIGHT steps.
+
+     Inputs: location      - Pointer to the location being generated.
+             exit_position - Coordinates of the exit, on the edge opposite the
+                             entrance.
+             direction     - Direction from the entrance's edge to the exit's.
+
+    Outputs: Coordinates of the last cell carved before reaching the exit.
+*******************************************************************************/
+GPoint carve_winding_path(location_t *const location,
+                          const GPoint exit_position,
+                          const int8_t direction) {
+  int8_t turns_left = BUILDER_TURNS_PER_ROW;
+  GPoint builder_position = location->entrance,
+         target = location->entrance,
+         previous_position;
+  const GPoint forward = g_direction_vectors[direction];
+
+  do {
+    carve_cell(location, builder_position);
+    previous_position = builder_position;
+
+    // Move the builder:
+    while (gpoint_equal(&builder_position, &target) && turns_left > 0) {
+      target = forward.x == 0 ? GPoint(rand() % MAP_WIDTH,
+                                       builder_position.y) :
+                                GPoint(builder_position.x,
+                                       rand() % MAP_HEIGHT);
+      turns_left--;
+    }
+    if (gpoint_equal(&builder_position, &target)) {
+      builder_position.x += forward.x;
+      builder_position.y += forward.y;
+      target = builder_position;
+      turns_left = BUILDER_TURNS_PER_ROW;
+      if (forward.x == 0 ? builder_position.y == exit_position.y :
+                           builder_position.x == exit_position.x) {
+        target = exit_position;
+        turns_left = 0;
+      }
+    } else {
+      builder_position.x += (target.x > builder_position.x) -
+                              (target.x < builder_position.x);
+      builder_position.y += (target.y > builder_position.y) -
+                              (target.y < builder_position.y);
+    }
+  }while (!gpoint_equal(&builder_position, &exit_position));
+
+  return previous_position;
+}
+
+/*******************************************************************************
+   Function: find_room_set
+
+Description: Finds the representative room of the set (of rooms known to be
+             connected to one another) containing a given room, halving the
+             path to it along the way.
+
+     Inputs: sets - Pointer to each room's parent in its set's tree.
+             room - Index of the room of interest.
+
+    Outputs: Index of the room representing the set.
+*******************************************************************************/
+int8_t find_room_set(int8_t *const sets, int8_t room) {
+  while (sets[room] != room) {
+    sets[room] = sets[sets[room]];
+    room = sets[room];
+  }
+
+  return room;
+}
+
+/*******************************************************************************
+   Function: is_connected
+
+Description: Determines, via a breadth-first flood fill over a given location's
+             non-solid cells (other than exits, which can't be walked through),
+             whether one cell can be reached from another. Uses
+             "g_distance_field_queue" for its queue, but leaves the distance
+             field itself alone.
+
+     Inputs: location - Pointer to the location of interest.
+             from     - Coordinates of the starting cell.
+             to       - Coordinates of the destination.
+
+    Outputs: "True" if an open path connects the two cells.
+*******************************************************************************/
+bool is_connected(const location_t *const location,
+                  const GPoint from,
+                  const GPoint to) {
+  int8_t i, type;
+  int16_t head = 0, tail = 0, neighbor_index;
+  GPoint cell, neighbor;
+  const int16_t from_index = from.y * MAP_WIDTH + from.x;
+
+  if (get_location_cell_type(location, from) == SOLID) {
+    return false;
+  }
+  memset(g_flood_fill_cells, 0, sizeof(g_flood_fill_cells));
+  g_flood_fill_cells[from_index / 32] |= (uint32_t) 1 << (from_index % 32);
+  g_distance_field_queue[tail++] = from_index;
+  while (head < tail) {
+    cell = GPoint(g_distance_field_queue[head] % MAP_WIDTH,
+                  g_distance_field_queue[head] / MAP_WIDTH);
+    head++;
+    if (gpoint_equal(&cell, &to)) {
+      return true;
+    }
+    for (i = 0; i < NUM_DIRECTIONS; ++i) {
+      neighbor = get_cell_farther_away(cell, i, 1);
+      type = get_location_cell_type(location, neighbor);
+      neighbor_index = neighbor.y * MAP_WIDTH + neighbor.x;
+      if (type != SOLID &&
+          type != EXIT &&
+          !(g_flood_fill_cells[neighbor_index / 32] >> (neighbor_index % 32) &
+            1)) {
+        g_flood_fill_cells[neighbor_index / 32] |=
+          (uint32_t) 1 << (neighbor_index % 32);
+        g_distance_field_queue[tail++] = neighbor_index;
+      }
+    }
+  }
+
+  return false;
+}
+
+/*******************************************************************************
+   Function: carve_rooms_and_corridors
+
+Description: Carves randomly placed rooms out of a given location, links them
+             with corridors (shortest first, adding a corridor between rooms
+             already linked only as an occasional loop), connects the entrance
+             and exit to their nearest rooms, then verifies via a flood fill
+             that the exit can be reached from the entrance. Work is bounded by
+             MAX_ROOMS and the map's size.
+
+     Inputs: location      - Pointer to the location being generated.
+             band          - Pointer to the generation parameters to use.
+             exit_position - Coordinates of the exit, on the edge opposite the
+                             entrance.
+             direction     - Direction from the entrance's edge to the exit's.
+
+    Outputs: Coordinates of the cell beside the exit, or (NONE, NONE) if the
+             exit can't be reached from the entrance.
+*******************************************************************************/
+GPoint carve_rooms_and_corridors(location_t *const location,
+                                 const level_band_t *const band,
+                                 const GPoint exit_position,
+                                 const int8_t direction) {
+  int8_t i, j, x, y, width, height, num_rooms = 0, num_links = 0,
+         num_loops = 0, set_a, set_b, sets[MAX_ROOMS];
+  uint16_t link,
+           links[MAX_ROOM_LINKS];  // Length, then each room's index (4 bits).
+  GRect rooms[MAX_ROOMS];
+  GPoint centers[MAX_ROOMS], endpoint, nearest, exit_approach;
+
+  // Place rooms, leaving walls between them and along the map's edges:
+  for (i = 0;
+       i < band->max_rooms * ROOM_PLACEMENT_ATTEMPTS &&
+         num_rooms < band->max_rooms;
+       ++i) {
+    width = band->min_room_size +
+            rand() % (band->max_room_size - band->min_room_size + 1);
+    height = band->min_room_size +
+             rand() % (band->max_room_size - band->min_room_size + 1);
+    if (width > MAP_WIDTH - 2) {
+      width = MAP_WIDTH - 2;
+    }
+    if (height > MAP_HEIGHT - 2) {
+      height = MAP_HEIGHT - 2;
+    }
+    x = 1 + rand() % (MAP_WIDTH - 1 - width);
+    y = 1 + rand() % (MAP_HEIGHT - 1 - height);
+    for (j = 0; j < num_rooms; ++j) {
+      if (x <= rooms[j].origin.x + rooms[j].size.w &&
+          rooms[j].origin.x <= x + width &&
+          y <= rooms[j].origin.y + rooms[j].size.h &&
+          rooms[j].origin.y <= y + height) {
+        break;  // Overlapping or adjacent.
+      }
+    }
+    if (j == num_rooms) {
+      rooms[num_rooms] = GRect(x, y, width, height);
+      centers[num_rooms] = GPoint(x + width / 2, y + height / 2);
+      sets[num_rooms] = num_rooms;
+      num_rooms++;
+      for (j = 0; j < width * height; ++j) {
+        carve_cell(location, GPoint(x + j % width, y + j / width));
+      }
+    }
+  }
+
+  // Sort every possible link between two rooms by length (insertion sort):
+  for (i = 0; i < num_rooms; ++i) {
+    for (j = i + 1; j < num_rooms; ++j) {
+      link = MANHATTAN_DISTANCE(centers[i], centers[j]) << 8 | i << 4 | j;
+      for (x = num_links++; x > 0 && links[x - 1] > link; --x) {
+        links[x] = links[x - 1];
+      }
+      links[x] = link;
     }
-    if (heavy_item->infused_pebble == PEBBLE_OF_SHADOW) {
-      g_player->int8_stats[PHYSICAL_DEFENSE]++;
+  }
+
+  // Link every room to the rest via the shortest corridors possible (i.e.,
+  // Kruskal's algorithm), with the occasional extra corridor forming a loop:
+  for (i = 0; i < num_links; ++i) {
+    set_a = find_room_set(sets, links[i] >> 4 & 0xF);
+    set_b = find_room_set(sets, links[i] & 0xF);
+    if (set_a != set_b ||
+        (num_loops < band->max_loops &&
+         rand() % 100 < band->loop_chance)) {
+      if (set_a == set_b) {
+        num_loops++;
+      }
+      sets[set_a] = set_b;
+      carve_corridor(location,
+                     centers[links[i] >> 4 & 0xF],
+                     centers[links[i] & 0xF]);
     }
   }
 
-  // Shield:
-  heavy_item = get_heavy_item_equipped_at(LEFT_HAND);
-  if (heavy_item) {
-    g_player->int8_stats[PHYSICAL_DEFENSE] += DEFAULT_ITEM_BONUS;
-    g_player->int8_stats[MAGICAL_POWER]--;
-    g_player->int8_stats[FATIGUE_RATE]++;
-    if (heavy_item->infused_pebble == PEBBLE_OF_SHADOW) {
-      g_player->int8_stats[PHYSICAL_DEFENSE]++;
+  // Connect the entrance and the cell beside the exit to their nearest rooms
+  // (or to each other, if no rooms fit):
+  exit_approach = GPoint(exit_position.x - g_direction_vectors[direction].x,
+                         exit_position.y - g_direction_vectors[direction].y);
+  for (i = 0; i < 2; ++i) {
+    endpoint = i == 0 ? location->entrance : exit_approach;
+    nearest = i == 0 ? exit_approach : location->entrance;
+    for (j = 0; j < num_rooms; ++j) {
+      if (j == 0 ||
+          MANHATTAN_DISTANCE(endpoint, centers[j]) <
+            MANHATTAN_DISTANCE(endpoint, nearest)) {
+        nearest = centers[j];
+      }
     }
+    carve_corridor(location, endpoint, nearest);
   }
 
-  // Ensure magical power doesn't fall too low:
-  if (g_player->int8_stats[MAGICAL_POWER] < DEFAULT_MAJOR_STAT_VALUE) {
-    g_player->int8_stats[MAGICAL_POWER] = DEFAULT_MAJOR_STAT_VALUE;
+  // Verify that the exit can be reached from the entrance:
+  if (!is_connected(location, location->entrance, exit_approach)) {
+    return GPoint(NONE, NONE);
   }
+
+  return exit_approach;
 }
 
 /*******************************************************************************
-   Function: init_player
+   Function: generate_location
 
-Description: Initializes the global player struct according to default values.
+Description: Sets up a new location in a given location struct, with an
+             entrance, an exit, and a single NPC of type "MAGE", laid out
+             according to the depth band of the level below the player's
+             current depth. Leaves the player, saved data and the current
+             location's caches alone, so the caches must be rebuilt (see
+             "init_npc_pool" and "init_map_caches") if the new location
+             becomes the current one.
 
-     Inputs: None.
+     Inputs: location - Pointer to the location struct to be set up.
+             entrance - Set to the coordinates of the new location's entrance
+                        (unless NULL).
 
-    Outputs: None.
+    Outputs: Direction from the entrance's edge of the map to the exit's.
 *******************************************************************************/
-void init_player(void) {
-  int8_t i;
+int8_t generate_location(location_t *const location, GPoint *const entrance) {
+  int8_t i, direction;
+  GPoint exit_position, mage_position = GPoint(NONE, NONE);
 
-  // Set major stats (attributes), etc.:
-  for (i = FIRST_MAJOR_STAT; i < NUM_MAJOR_STATS + FIRST_MAJOR_STAT; ++i) {
-    g_player->int8_stats[i] = DEFAULT_MAJOR_STAT_VALUE;
+  // Set color scheme:
+  location->floor_color_scheme = rand() % NUM_BACKGROUND_COLOR_SCHEMES;
+  location->wall_color_scheme = rand() % NUM_BACKGROUND_COLOR_SCHEMES;
+
+  // Remove any preexisting NPCs (restarting the clock their status effects
+  // expire against):
+  location->tick_count = 0;
+  for (i = 0; i < MAX_NPCS_AT_ONE_TIME; ++i) {
+    location->npcs[i].type = NONE;
   }
-  g_player->int8_stats[LEVEL] =
-    g_player->int8_stats[HEALTH_REGEN] =
-    g_player->int8_stats[ENERGY_REGEN] = 1;
-  g_player->exp_points =  // 58806 to reach max. level!
-    g_player->int8_stats[DEPTH] =
-    g_player->int8_stats[BACKLASH_DAMAGE] =
-    g_player->int8_stats[SHADOW_FORM] = 0;
 
-  // Assign starting inventory:
-  for (i = 0; i < NUM_PEBBLE_TYPES; ++i) {
-    g_player->pebbles[i] = 0;
+  // Now set each cell to solid:
+  clear_location_map(location);
+
+  // Next, set entrance and exit points on opposite edges:
+  switch (direction = rand() % NUM_DIRECTIONS) {
+    case NORTH:
+      location->entrance = RANDOM_POINT_SOUTH;
+      exit_position = RANDOM_POINT_NORTH;
+      break;
+    case SOUTH:
+      location->entrance = RANDOM_POINT_NORTH;
+      exit_position = RANDOM_POINT_SOUTH;
+      break;
+    case EAST:
+      location->entrance = RANDOM_POINT_WEST;
+      exit_position = RANDOM_POINT_EAST;
+      break;
+    default:  // case WEST:
+      location->entrance = RANDOM_POINT_EAST;
+      exit_position = RANDOM_POINT_WEST;
+      break;
   }
-  g_player->equipped_pebble = NONE;
-  for (i = 1; i < MAX_HEAVY_ITEMS; ++i) {
-    init_heavy_item(&g_player->heavy_items[i], NONE);
+  set_location_cell_type(location, exit_position, EXIT);
+
+  // Now carve a way from the entrance to the exit, per the new depth's band,
+  // falling back on a winding path if rooms fail to connect the two:
+  i = NUM_LEVEL_BANDS - 1;
+  while (i > 0 &&
+         g_level_bands[i].min_depth > g_player->int8_stats[DEPTH] + 1) {
+    --i;
+  }
+  if (g_level_bands[i].layout == ROOMS_AND_CORRIDORS_LAYOUT) {
+    mage_position = carve_rooms_and_corridors(location,
+                                              &g_level_bands[i],
+                                              exit_position,
+                                              direction);
+    if (mage_position.x == NONE) {
+      clear_location_map(location);
+      set_location_cell_type(location, exit_position, EXIT);
+    }
+  }
+  if (mage_position.x == NONE) {
+    mage_position = carve_winding_path(location, exit_position, direction);
   }
-  init_heavy_item(&g_player->heavy_items[0], ROBE);
 
-  // Equip the robe, causing all minor stats to be set:
-  equip_heavy_item(&g_player->heavy_items[0]);
+  // Ensure a mage will be generated next to the exit (in the pool's first
+  // slot):
+  init_npc_struct(&location->npcs[0],
+                  MAGE,
+                  mage_position,
+                  location->tick_count);
+  link_npc_pool(location);
+
+  // Remove the exit if the new depth is the maximum:
+  if (g_player->int8_stats[DEPTH] + 1 == MAX_DEPTH) {
+    set_location_cell_type(location, exit_position, EMPTY);
+  }
+  if (entrance != NULL) {
+    *entrance = location->entrance;
+  }
 
-  // Finally, ensure health and energy are at 100%:
-  g_player->int16_stats[CURRENT_HEALTH] = g_player->int16_stats[MAX_HEALTH];
-  g_player->int16_stats[CURRENT_ENERGY] = g_player->int16_stats[MAX_ENERGY];
+  return direction;
 }
 
 /*******************************************************************************
-   Function: init_npc
+   Function: init_location
 
-Description: Initializes a given non-player character (NPC) struct according to
-             a given NPC type and starting position.
+Description: Moves the player down to a new location: the one prefetched
+             during idle time, if it's ready, or else a freshly generated one.
+             Saving to persistent storage is left to idle time as well.
 
-     Inputs: npc      - Pointer to the NPC struct to be initialized.
-             type     - Integer indicating the desired NPC type.
-             position - The NPC's starting position.
+     Inputs: None.
 
     Outputs: None.
 *******************************************************************************/
-void init_npc(npc_t *const npc, const int8_t type, const GPoint position) {
-  int8_t i;
-
-  npc->type = type;
-  npc->position = position;
-  npc->item = NONE;
-  for (i = 0; i < NUM_STATUS_EFFECTS; ++i) {
-    npc->status_effects[i] = 0;
+void init_location(void) {
+  int8_t direction;
+  GPoint entrance;
+  location_t *const previous_location = g_location;
+
+  if (g_next_location_is_ready) {
+    g_location = g_next_location;
+    g_next_location = previous_location;
+    g_next_location_is_ready = false;
+    direction = g_next_location_direction;
+    entrance = g_location->entrance;
+  } else {
+    direction = generate_location(g_location, &entrance);
   }
+  g_player->position = entrance;
+  init_npc_pool();
+  init_map_caches();
+  set_player_direction(direction);
+  g_player->int8_stats[DEPTH]++;
+  g_location_needs_saving = true;
+  schedule_idle_work();
+}
 
-  // Set stats according to current dungeon depth:
-  npc->health = npc->power = npc->physical_defense = npc->magical_defense =
-    1 + g_player->int8_stats[DEPTH] - g_player->int8_stats[DEPTH] / 2;
+/*******************************************************************************
+   Function: prefetch_next_location
 
-  // Check for increased power:
-  if (type <= WHITE_MONSTER_MEDIUM ||
-      type == WARRIOR_MEDIUM ||
-      type == WARRIOR_LARGE ||
-      (type >= DARK_OGRE && type <= PALE_TROLL)) {
-    npc->power++;
-  }
-  if (type <= WHITE_MONSTER_LARGE ||
-      type == WARRIOR_LARGE ||
-      type == DARK_OGRE ||
-      type == PALE_OGRE) {
-    npc->power++;
-  }
+Description: Generates the location below the current one into
+             "g_next_location" (if there's room for it), so that taking the
+             exit needn't wait for it. The current location, and everything
+             derived from it, is left alone.
 
-  // Check for increased/decreased defenses:
-  if (type == MAGE || (type < WARRIOR_LARGE && type % 2)) {
-    npc->magical_defense++;
-    npc->physical_defense--;
-  } else if (type >= WARRIOR_LARGE) {
-    npc->physical_defense++;
-  }
+     Inputs: None.
 
-  // Some NPCs may carry a random item:
-  if (type > WHITE_MONSTER_SMALL) {
-    npc->item = rand() % 2 ? NONE : RANDOM_ITEM;  // Excludes Pebbles.
+    Outputs: None.
+*******************************************************************************/
+void prefetch_next_location(void) {
+  if (g_next_location == NULL || g_next_location_is_ready) {
+    return;
   }
+  g_next_location_direction = generate_location(g_next_location, NULL);
+  g_next_location_is_ready = true;
+}
 
-  // Mages are the only source of Pebbles:
-  if (type == MAGE) {
-    npc->item = rand() % NUM_PEBBLE_TYPES;
+/*******************************************************************************
+   Function: write_storage_range
+
+Description: Writes data to persistent storage, split across consecutive keys
+             of up to PERSIST_DATA_MAX_LENGTH bytes each.
+
+     Inputs: first_key - The first key of the range.
+             data      - Pointer to the data.
+             size      - Number of bytes to be written.
+
+    Outputs: "False" if any write failed (e.g., storage is full).
+*******************************************************************************/
+bool write_storage_range(const uint32_t first_key,
+                         const void *data,
+                         const int16_t size) {
+  int16_t i;
+
+  for (i = 0; i < size; i += PERSIST_DATA_MAX_LENGTH) {
+    if (persist_write_data(first_key + i / PERSIST_DATA_MAX_LENGTH,
+                           (const uint8_t *) data + i,
+                           size - i < PERSIST_DATA_MAX_LENGTH ?
+                             size - i : PERSIST_DATA_MAX_LENGTH) < 0) {
+      return false;
+    }
   }
+
+  return true;
 }
 
 /*******************************************************************************
-   Function: init_heavy_item
+   Function: read_storage_range
 
-Description: Initializes a new heavy item struct according to a given type.
+Description: Reads data written by "write_storage_range".
 
-     Inputs: item - Pointer to the heavy item struct.
-             type - The type of heavy item to be initialized.
+     Inputs: first_key - The first key of the range.
+             data      - Pointer to space for the data.
+             size      - Number of bytes to be read.
 
     Outputs: None.
 *******************************************************************************/
-void init_heavy_item(heavy_item_t *const item, const int8_t type) {
-  item->type = type;
-  item->infused_pebble = NONE;
-  item->equipped = false;
-  if (type < SHIELD) {
-    item->equip_target = RIGHT_HAND;
-  } else if (type == SHIELD) {
-    item->equip_target = LEFT_HAND;
-  } else {
-    item->equip_target = BODY;
+void read_storage_range(const uint32_t first_key,
+                        void *data,
+                        const int16_t size) {
+  int16_t i;
+
+  for (i = 0; i < size; i += PERSIST_DATA_MAX_LENGTH) {
+    persist_read_data(first_key + i / PERSIST_DATA_MAX_LENGTH,
+                      (uint8_t *) data + i,
+                      size - i < PERSIST_DATA_MAX_LENGTH ?
+                        size - i : PERSIST_DATA_MAX_LENGTH);
   }
 }
 
 /*******************************************************************************
-   Function: init_wall_coords
+   Function: save_location
 
-Description: Initializes the global "back_wall_coords" array so it contains the
-             top-left and bottom-right coordinates for every potential back wall
-             location on the screen. (This establishes the field of view and
-             sense of perspective while also facilitating convenient drawing of
-             the 3D environment.)
+Description: Saves the current location to persistent storage, each part at
+             its own fixed range of keys: the storage format, a header, the
+             terrain, the used part of the side table of exits and loot, then
+             the live NPCs, packed into as few keys as possible.
 
      Inputs: None.
 
-    Outputs: None.
+    Outputs: "False" if any write failed (e.g., storage is full), in which case
+             the saved location is incomplete.
 *******************************************************************************/
-void init_wall_coords(void) {
-  uint8_t i, j, wall_width;
-  const float perspective_modifier = 2.0;  // Helps determine FOV, etc.
-
-  for (i = 0; i < MAX_VISIBILITY_DEPTH - 1; ++i) {
-    for (j = 0; j < (STRAIGHT_AHEAD * 2) + 1; ++j) {
-      g_back_wall_coords[i][j][TOP_LEFT] = GPoint(0, 0);
-      g_back_wall_coords[i][j][BOTTOM_RIGHT] = GPoint(0, 0);
+bool save_location(void) {
+  int8_t i, j;
+  npc_t npcs[NPCS_PER_STORAGE_KEY];
+  const location_header_t header = {
+    .floor_color_scheme = g_location->floor_color_scheme,
+    .wall_color_scheme = g_location->wall_color_scheme,
+    .entrance = g_location->entrance,
+    .tick_count = g_location->tick_count,
+    .num_special_cells = g_location->num_special_cells,
+    .num_active_npcs = g_location->num_active_npcs,
+  };
+
+  if (persist_read_int(STORAGE_FORMAT_KEY) != STORAGE_FORMAT) {
+    persist_delete(LEGACY_LOCATION_STORAGE_KEY);
+    if (persist_write_int(STORAGE_FORMAT_KEY, STORAGE_FORMAT) < 0) {
+      return false;
     }
   }
-  for (i = 0; i < MAX_VISIBILITY_DEPTH - 1; ++i) {
-    g_back_wall_coords[i][STRAIGHT_AHEAD][TOP_LEFT] =
-      GPoint(FIRST_WALL_OFFSET - i * perspective_modifier,
-             FIRST_WALL_OFFSET - i * perspective_modifier);
-    if (i > 0) {
-      g_back_wall_coords[i][STRAIGHT_AHEAD][TOP_LEFT].x +=
-        g_back_wall_coords[i - 1][STRAIGHT_AHEAD][TOP_LEFT].x;
-      g_back_wall_coords[i][STRAIGHT_AHEAD][TOP_LEFT].y +=
-        g_back_wall_coords[i - 1][STRAIGHT_AHEAD][TOP_LEFT].y;
+  if (persist_write_data(LOCATION_HEADER_STORAGE_KEY,
+                         &header,
+                         sizeof(header)) < 0 ||
+      !write_storage_range(TERRAIN_STORAGE_KEY,
+                           g_location->terrain,
+                           TERRAIN_SIZE) ||
+      !write_storage_range(SPECIAL_CELLS_STORAGE_KEY,
+                           g_location->special_cells,
+                           header.num_special_cells *
+                             sizeof(special_cell_t))) {
+    return false;
+  }
+  for (i = 0; i < header.num_active_npcs; i += j) {
+    for (j = 0;
+         j < (int8_t) NPCS_PER_STORAGE_KEY && i + j < header.num_active_npcs;
+         ++j) {
+      npcs[j] = g_location->npcs[g_location->active_npcs[i + j]];
     }
-    g_back_wall_coords[i][STRAIGHT_AHEAD][BOTTOM_RIGHT].x =
-      GRAPHICS_FRAME_WIDTH - g_back_wall_coords[i][STRAIGHT_AHEAD][TOP_LEFT].x;
-    g_back_wall_coords[i][STRAIGHT_AHEAD][BOTTOM_RIGHT].y =
-      GRAPHICS_FRAME_HEIGHT -
-        g_back_wall_coords[i][STRAIGHT_AHEAD][TOP_LEFT].y;
-    wall_width = g_back_wall_coords[i][STRAIGHT_AHEAD][BOTTOM_RIGHT].x -
-                   g_back_wall_coords[i][STRAIGHT_AHEAD][TOP_LEFT].x;
-    for (j = 1; j <= STRAIGHT_AHEAD; ++j) {
-      g_back_wall_coords[i][STRAIGHT_AHEAD - j][TOP_LEFT] =
-        g_back_wall_coords[i][STRAIGHT_AHEAD][TOP_LEFT];
-      g_back_wall_coords[i][STRAIGHT_AHEAD - j][TOP_LEFT].x -= wall_width * j;
-      g_back_wall_coords[i][STRAIGHT_AHEAD - j][BOTTOM_RIGHT] =
-        g_back_wall_coords[i][STRAIGHT_AHEAD][BOTTOM_RIGHT];
-      g_back_wall_coords[i][STRAIGHT_AHEAD - j][BOTTOM_RIGHT].x -= wall_width *
-                                                                     j;
-      g_back_wall_coords[i][STRAIGHT_AHEAD + j][TOP_LEFT] =
-        g_back_wall_coords[i][STRAIGHT_AHEAD][TOP_LEFT];
-      g_back_wall_coords[i][STRAIGHT_AHEAD + j][TOP_LEFT].x += wall_width * j;
-      g_back_wall_coords[i][STRAIGHT_AHEAD + j][BOTTOM_RIGHT] =
-        g_back_wall_coords[i][STRAIGHT_AHEAD][BOTTOM_RIGHT];
-      g_back_wall_coords[i][STRAIGHT_AHEAD + j][BOTTOM_RIGHT].x += wall_width *
-                                                                     j;
+    if (persist_write_data(FIRST_NPC_STORAGE_KEY + i / NPCS_PER_STORAGE_KEY,
+                           npcs,
+                           j * sizeof(npc_t)) < 0) {
+      return false;
     }
   }
+
+  return true;
 }
 
 /*******************************************************************************
-   Function: init_location
+   Function: save_game
 
-Description: Initializes the global location struct, setting up a new location
-             with an entrance, an exit, and a single NPC of type "MAGE". Also
-             saves data to persistent storage as a precaution.
+Description: Saves the player and the current location to persistent storage,
+             logging an error if that fails.
 
      Inputs: None.
 
     Outputs: None.
 *******************************************************************************/
-void init_location(void) {
-  int8_t i, j, builder_direction;
-  GPoint builder_position;
+void save_game(void) {
+  if (persist_write_data(PLAYER_STORAGE_KEY, g_player, sizeof(player_t)) < 0 ||
+      !save_location()) {
+    APP_LOG(APP_LOG_LEVEL_ERROR, "Failed to save the game.");
+  }
+}
 
-  // Set color scheme:
-  g_location->floor_color_scheme = rand() % NUM_BACKGROUND_COLOR_SCHEMES;
-  g_location->wall_color_scheme = rand() % NUM_BACKGROUND_COLOR_SCHEMES;
+/*******************************************************************************
+   Function: load_location
 
-  // Remove any preexisting NPCs:
-  for (i = 0; i < MAX_NPCS_AT_ONE_TIME; ++i) {
-    g_location->npcs[i].type = NONE;
-  }
+Description: Loads the current location from persistent storage (see
+             "save_location"), including locations saved by older versions
+             along with their NPCs.
 
-  // Now set each cell to solid:
-  for (i = 0; i < MAP_WIDTH; ++i) {
-    for (j = 0; j < MAP_HEIGHT; ++j) {
-      g_location->map[i][j] = SOLID;
-    }
-  }
+     Inputs: None.
 
-  // Next, set entrance and exit points:
-  switch (builder_direction = rand() % NUM_DIRECTIONS) {
-    case NORTH:
-      builder_position = RANDOM_POINT_SOUTH;
-      set_cell_type(RANDOM_POINT_NORTH, EXIT);
-      break;
-    case SOUTH:
-      builder_position = RANDOM_POINT_NORTH;
-      set_cell_type(RANDOM_POINT_SOUTH, EXIT);
-      break;
-    case EAST:
-      builder_position = RANDOM_POINT_WEST;
-      set_cell_type(RANDOM_POINT_EAST, EXIT);
-      break;
-    default:  // case WEST:
-      builder_position = RANDOM_POINT_EAST;
-      set_cell_type(RANDOM_POINT_WEST, EXIT);
-      break;
-  }
-  g_player->position = GPoint(builder_position.x, builder_position.y);
-  g_location->entrance = GPoint(builder_position.x, builder_position.y);
-  set_player_direction(builder_direction);
+    Outputs: "False" if the saved location doesn't fit this build (e.g., it was
+             saved with other map dimensions), in which case the current
+             location is left as is.
+*******************************************************************************/
+bool load_location(void) {
+  int8_t i, j;
+  location_header_t header;
+  legacy_location_t legacy_location;
+  legacy_npc_t *legacy_npc;
+  npc_t *npc;
 
-  // Now carve a path between the entrance and exit points:
-  while (get_cell_type(builder_position) != EXIT) {
-    // Add random loot or simply make the cell EMPTY:
-    if (rand() % 25 == 0 &&
-        !gpoint_equal(&builder_position, &g_location->entrance)) {
-      set_cell_type(builder_position, RANDOM_ITEM);  // Excludes Pebbles.
-    } else {
-      set_cell_type(builder_position, EMPTY);
+  if (persist_exists(STORAGE_FORMAT_KEY)) {
+    if (persist_read_int(STORAGE_FORMAT_KEY) != STORAGE_FORMAT ||
+        persist_read_data(LOCATION_HEADER_STORAGE_KEY,
+                          &header,
+                          sizeof(header)) != (int) sizeof(header) ||
+        header.num_special_cells < 0 ||
+        header.num_special_cells > MAX_SPECIAL_CELLS ||
+        header.num_active_npcs < 0 ||
+        header.num_active_npcs > MAX_NPCS_AT_ONE_TIME) {
+      return false;
     }
-
-    // Move the builder:
-    switch (builder_direction) {
-      case NORTH:
-        if (builder_position.y > 0) {
-          builder_position.y--;
-        }
-        break;
-      case SOUTH:
-        if (builder_position.y < MAP_HEIGHT - 1) {
-          builder_position.y++;
-        }
-        break;
-      case EAST:
-        if (builder_position.x < MAP_WIDTH - 1) {
-          builder_position.x++;
-        }
-        break;
-      default:  // case WEST:
-        if (builder_position.x > 0) {
-          builder_position.x--;
-        }
-        break;
+    for (i = 0; i < MAX_NPCS_AT_ONE_TIME; ++i) {
+      g_location->npcs[i].type = NONE;
     }
-
-    // Ensure a mage will be generated next to the exit:
-    init_npc(&g_location->npcs[0], MAGE, builder_position);
-
-    // 50% chance of turning:
-    if (rand() % 2) {
-      builder_direction = rand() % NUM_DIRECTIONS;
+    g_location->floor_color_scheme = header.floor_color_scheme;
+    g_location->wall_color_scheme = header.wall_color_scheme;
+    g_location->entrance = header.entrance;
+    g_location->tick_count = header.tick_count;
+    g_location->num_special_cells = header.num_special_cells;
+    read_storage_range(TERRAIN_STORAGE_KEY, g_location->terrain, TERRAIN_SIZE);
+    read_storage_range(SPECIAL_CELLS_STORAGE_KEY,
+                       g_location->special_cells,
+                       header.num_special_cells * sizeof(special_cell_t));
+    for (i = 0; i < header.num_active_npcs; i += j) {
+      j = header.num_active_npcs - i < (int8_t) NPCS_PER_STORAGE_KEY ?
+            header.num_active_npcs - i : (int8_t) NPCS_PER_STORAGE_KEY;
+      persist_read_data(FIRST_NPC_STORAGE_KEY + i / NPCS_PER_STORAGE_KEY,
+                        &g_location->npcs[i],
+                        j * sizeof(npc_t));
+    }
+  } else {
+    for (i = 0; i < MAX_NPCS_AT_ONE_TIME; ++i) {
+      g_location->npcs[i].type = NONE;
+    }
+    // Older versions stored a byte per cell of a 10x10 map, and status effects
+    // as one-byte countdowns:
+    persist_read_data(LEGACY_LOCATION_STORAGE_KEY,
+                      &legacy_location,
+                      sizeof(legacy_location_t));
+    clear_map();
+    for (i = 0; i < LEGACY_MAP_WIDTH && i < MAP_WIDTH; ++i) {
+      for (j = 0; j < LEGACY_MAP_WIDTH && j < MAP_HEIGHT; ++j) {
+        set_cell_type(GPoint(i, j), legacy_location.map[i][j]);
+      }
+    }
+    g_location->floor_color_scheme = legacy_location.floor_color_scheme;
+    g_location->wall_color_scheme = legacy_location.wall_color_scheme;
+    g_location->entrance = legacy_location.entrance;
+    g_location->tick_count = 0;
+    for (i = 0; i < LEGACY_MAX_NPCS_AT_ONE_TIME; ++i) {
+      npc = &g_location->npcs[i];
+      legacy_npc = &legacy_location.npcs[i];
+      npc->position = legacy_npc->position;
+      npc->type = legacy_npc->type;
+      npc->item = legacy_npc->item;
+      npc->health = legacy_npc->health;
+      npc->power = legacy_npc->power;
+      npc->physical_defense = legacy_npc->physical_defense;
+      npc->magical_defense = legacy_npc->magical_defense;
+      for (j = 0; j < NUM_STATUS_EFFECTS; ++j) {
+        npc->status_effect_expiry_ticks[j] = legacy_npc->status_effects[j];
+      }
     }
   }
+  init_npc_pool();
+  init_map_caches();
 
-  // Increment the player's depth, then remove the exit if at maximum depth:
-  g_player->int8_stats[DEPTH]++;
-  if (g_player->int8_stats[DEPTH] == MAX_DEPTH) {
-    set_cell_type(builder_position, EMPTY);
-  }
-
-  // Save data to persistent storage as a precaution:
-  persist_write_data(PLAYER_STORAGE_KEY, g_player, sizeof(player_t));
-  persist_write_data(LOCATION_STORAGE_KEY, g_location, sizeof(location_t));
+  return true;
 }
 
 /*******************************************************************************
@@ -3174,12 +5666,21 @@ void init_window(const int8_t window_index) {
     window_set_background_color(g_windows[window_index], GColorBlack);
     window_set_window_handlers(g_windows[window_index], (WindowHandlers) {
       .appear = graphics_window_appear,
+      .disappear = graphics_window_disappear,
     });
     window_set_click_config_provider(g_windows[window_index],
                                      (ClickConfigProvider)
                                        graphics_click_config_provider);
-    layer_set_update_proc(window_get_root_layer(g_windows[window_index]),
-                          draw_scene);
+    g_scene_layer = layer_create(layer_get_bounds(window_get_root_layer(
+                                                     g_windows[window_index])));
+    layer_set_update_proc(g_scene_layer, draw_scene);
+    layer_add_child(window_get_root_layer(g_windows[window_index]),
+                    g_scene_layer);
+    g_overlay_layer = layer_create(layer_get_bounds(window_get_root_layer(
+                                                     g_windows[window_index])));
+    layer_set_update_proc(g_overlay_layer, draw_overlay);
+    layer_add_child(window_get_root_layer(g_windows[window_index]),
+                    g_overlay_layer);
 
     // Colors for magical effects:
     g_magic_type_colors[PEBBLE_OF_THUNDER][0] = GColorYellow;
@@ -3314,6 +5815,9 @@ void deinit_window(const int8_t window_index) {
     menu_layer_destroy(g_menu_layers[window_index]);
   } else if (window_index == NARRATION_WINDOW) {
     text_layer_destroy(g_narration_text_layer);
+  } else {  // if (window_index == GRAPHICS_WINDOW)
+    layer_destroy(g_overlay_layer);
+    layer_destroy(g_scene_layer);
   }
   status_bar_layer_destroy(g_status_bars[window_index]);
   window_destroy(g_windows[window_index]);
@@ -3337,6 +5841,28 @@ void init(void) {
   // Set up graphics window and graphics-related variables:
   init_window(GRAPHICS_WINDOW);
   init_wall_coords();
+  g_floor_and_ceiling_bitmap = gbitmap_create_blank(
+    GSize(GRAPHICS_FRAME_WIDTH,
+          g_back_wall_coords[MAX_VISIBILITY_DEPTH - 2][0][TOP_LEFT].y),
+    GBitmapFormat8Bit);
+  g_floor_and_ceiling_color_scheme = NONE;
+  g_scene_bitmap = gbitmap_create_blank(GSize(SCREEN_WIDTH,
+                                              SCREEN_HEIGHT -
+                                                STATUS_BAR_HEIGHT),
+                                        GBitmapFormat8Bit);
+  g_scene_is_cached = false;
+  for (i = 0; i < NPC_SPRITE_ATLAS_SIZE; ++i) {
+    g_npc_sprites[i].npc_type = NONE;
+    g_npc_sprites[i].bitmap = NULL;
+  }
+  g_npc_sprite_clock = 0;
+#ifdef BENCHMARK_RENDERING
+  g_benchmark_map = NONE;
+#endif
+  g_animation_timer = NULL;
+  g_idle_timer = NULL;
+  g_last_backlight_request = 0;
+  memset(g_power_counters, 0, sizeof(g_power_counters));
   g_player_is_attacking = false;
   g_compass_path = gpath_create(&COMPASS_PATH_INFO);
   gpath_move_to(g_compass_path, GPoint(SCREEN_CENTER_POINT_X,
@@ -3347,12 +5873,23 @@ void init(void) {
   // Load saved data or initialize a brand new player struct:
   g_player = malloc(sizeof(player_t));
   g_location = malloc(sizeof(location_t));
+  g_next_location = malloc(sizeof(location_t));  // NULL disables prefetching.
+  g_next_location_is_ready = g_location_needs_saving = false;
   if (persist_exists(PLAYER_STORAGE_KEY)) {
     persist_read_data(PLAYER_STORAGE_KEY, g_player, sizeof(player_t));
-    persist_read_data(LOCATION_STORAGE_KEY, g_location, sizeof(location_t));
+    if (!load_location()) {  // Saved with other map dimensions.
+      memset(g_location, 0, sizeof(location_t));
+      memset(g_npc_grid, NONE, sizeof(g_npc_grid));
+      if (g_player->int8_stats[DEPTH] > 0) {
+        g_player->int8_stats[DEPTH]--;  // Replaced at the same depth.
+        init_location();
+      }
+    }
     set_player_direction(g_player->direction);  // To update compass.
   } else {
     init_player();
+    memset(g_location, 0, sizeof(location_t));  // No location yet.
+    memset(g_npc_grid, NONE, sizeof(g_npc_grid));
   }
 
   // Initialize all other windows and display the main menu:
@@ -3361,9 +5898,9 @@ void init(void) {
   }
   show_window(MAIN_MENU, ANIMATED);
 
-  // Subscribe to relevant services:
+  // Subscribe to relevant services (ticks are handled only while the graphics
+  // window is visible):
   app_focus_service_subscribe(app_focus_handler);
-  tick_timer_service_subscribe(SECOND_UNIT, tick_handler);
 }
 
 /*******************************************************************************
@@ -3378,12 +5915,32 @@ Description: Deinitializes the PebbleQuest app.
 void deinit(void) {
   int8_t i;
 
-  persist_write_data(PLAYER_STORAGE_KEY, g_player, sizeof(player_t));
-  persist_write_data(LOCATION_STORAGE_KEY, g_location, sizeof(location_t));
+#ifdef BENCHMARK_RENDERING
+  if (g_benchmark_map > NONE) {
+    end_benchmark();
+  }
+#endif
+  if (g_idle_timer) {
+    app_timer_cancel(g_idle_timer);
+  }
+  save_game();
   tick_timer_service_unsubscribe();
   app_focus_service_unsubscribe();
   free(g_player);
   free(g_location);
+  free(g_next_location);
+  free(g_wall_columns);
+  if (g_floor_and_ceiling_bitmap) {
+    gbitmap_destroy(g_floor_and_ceiling_bitmap);
+  }
+  if (g_scene_bitmap) {
+    gbitmap_destroy(g_scene_bitmap);
+  }
+  for (i = 0; i < NPC_SPRITE_ATLAS_SIZE; ++i) {
+    if (g_npc_sprites[i].bitmap) {
+      gbitmap_destroy(g_npc_sprites[i].bitmap);
+    }
+  }
   for (i = 0; i < NUM_WINDOWS; ++i) {
     deinit_window(i);
   }
@@ -12,6 +12,30 @@ Description: Header file for PebbleQuest, a first-person 3D fantasy RPG
 #define PEBBLE_QUEST_H_
 
 #include <pebble.h>
+#include <stddef.h>  // offsetof()
+
+// Uncomment to log a checksum of every rendered frame (for comparing renderer
+// changes against golden logs from the emulator via "pebble logs"):
+//#define LOG_FRAME_CHECKSUMS
+
+// Uncomment to time each stage of the graphics window's redraws and log the
+// per-stage min./avg./max. times every PROFILER_NUM_FRAMES frames:
+//#define PROFILE_FRAME_STAGES
+
+// Uncomment to request the backlight at most once every
+// BACKLIGHT_REQUEST_INTERVAL seconds, rather than on every redraw and tick
+// (each request keeps the light on for longer than that):
+//#define LIMIT_BACKLIGHT_REQUESTS
+
+// Uncomment to benchmark the renderer whenever the graphics window appears: the
+// player is placed on every open cell of each benchmark map, facing each
+// direction, and draw_scene()'s p50/p95/p99 times and draw calls are logged:
+//#define BENCHMARK_RENDERING
+
+// Uncomment (or pass via CFLAGS) to change the map dimensions, in cells, from
+// the default 10x10 (each may be up to 64):
+//#define MAP_WIDTH 64
+//#define MAP_HEIGHT 64
 
 /*******************************************************************************
   Enumerations
@@ -74,6 +98,14 @@ enum {
   EXIT
 };
 
+// Terrain codes (stored two bits per cell in "location_t.terrain"):
+enum {
+  SOLID_TERRAIN,  // Must be zero.
+  EMPTY_TERRAIN,
+  SPECIAL_TERRAIN,  // An exit or loot (see "location_t.special_cells").
+  NUM_TERRAIN_CODES
+};
+
 // Equip targets (i.e., places where an item may be equipped):
 enum {
   BODY,
@@ -155,6 +187,51 @@ enum {
   NUM_DIRECTIONS
 };
 
+// Wall sides (index values for "g_wall_quads"):
+enum {
+  BACK_WALL,
+  LEFT_WALL,
+  RIGHT_WALL,
+  NUM_WALL_SIDES
+};
+
+// Power counters (index values for "g_power_counters"):
+enum {
+  TICKS_HANDLED,
+  REDRAWS_SKIPPED,
+  BACKLIGHT_REQUESTS,
+  NUM_POWER_COUNTERS
+};
+
+// Frame profiler stages (index values for "g_profiler_stage_times"):
+enum {
+  SCENE_CACHE_STAGE,
+  FLOOR_AND_CEILING_STAGE,
+  VISIBILITY_STAGE,
+  WALLS_STAGE,
+  CELL_CONTENTS_STAGE,
+  ATTACK_SLASH_STAGE,
+  SPELL_BEAMS_STAGE,
+  STATUS_METERS_STAGE,
+  COMPASS_STAGE,
+  NUM_PROFILER_STAGES
+};
+
+// Level layouts (see "g_level_bands"):
+enum {
+  WINDING_PATH_LAYOUT,
+  ROOMS_AND_CORRIDORS_LAYOUT,
+  NUM_LEVEL_LAYOUTS
+};
+
+// Benchmark maps (index values for "g_benchmark_maps"):
+enum {
+  CORRIDORS_BENCHMARK_MAP,
+  OPEN_BENCHMARK_MAP,
+  CROWDED_BENCHMARK_MAP,
+  NUM_BENCHMARK_MAPS
+};
+
 /*******************************************************************************
   Other Constants
 *******************************************************************************/
@@ -162,6 +239,7 @@ enum {
 #define NUM_MAJOR_STATS                  3  // AGILITY, STRENGTH, INTELLECT
 #define FIRST_MAJOR_STAT                 AGILITY
 #define NUM_NEGATIVE_STAT_CONSTANTS      3
+#define NUM_OVERLAY_STATS                4  // Current and max. health and energy
 #define NUM_MENUS                        (STATS_MENU + 1)
 #define DEFAULT_MAJOR_STAT_VALUE         1  // AGILITY, STRENGTH, INTELLECT
 #define DEFAULT_MAX_HEALTH               10
@@ -169,9 +247,51 @@ enum {
 #define MIN_DAMAGE_TO_NPC                1
 #define MIN_FATIGUE_RATE                 2
 #define DEFAULT_ITEM_BONUS               3
-#define MAX_NPCS_AT_ONE_TIME             2
+#define MAX_NPCS_AT_ONE_TIME             32  // Per location's NPC pool.
+// NPCs saved with the location by older versions:
+#define LEGACY_MAX_NPCS_AT_ONE_TIME      2
+#define MAX_STATUS_EFFECT_DURATION       255  // In ticks.
+// Ticks between resets of NPCs' expired status effects (well within the range
+// of their 16-bit expiry ticks, so none can appear to come back):
+#define STATUS_EFFECT_SWEEP_INTERVAL     32768
+#ifndef MAP_WIDTH
 #define MAP_WIDTH                        10
+#endif
+#ifndef MAP_HEIGHT
 #define MAP_HEIGHT                       MAP_WIDTH
+#endif
+// Apps get 4 KB of persistent storage, and a 64x64 location takes up to 2.6 KB
+// of it (terrain, a full side table and 32 NPCs) alongside the player:
+#if MAP_WIDTH > 64 || MAP_HEIGHT > 64
+#error "Maps may be up to 64x64 cells (see the storage keys)."
+#endif
+#define TERRAIN_BITS_PER_CELL            2
+#define TERRAIN_CELLS_PER_BYTE           (8 / TERRAIN_BITS_PER_CELL)
+#define TERRAIN_MASK                     ((1 << TERRAIN_BITS_PER_CELL) - 1)
+#define TERRAIN_SIZE                     ((MAP_WIDTH * MAP_HEIGHT + TERRAIN_CELLS_PER_BYTE - 1) / TERRAIN_CELLS_PER_BYTE)
+// Exits and loot per location (loot turns up in about 1 in 50 cells, and the
+// last entry is kept for the exit):
+#define MAX_SPECIAL_CELLS                (16 + MAP_WIDTH * MAP_HEIGHT / 16)
+#define SPECIAL_CELL_INDEX(cell)         ((cell).y * MAP_WIDTH + (cell).x)
+// Bits per row of "g_solid_cells", and per column of "g_solid_cell_columns"
+// (including their borders):
+#define SOLID_CELLS_STRIDE               (MAP_WIDTH + 2)
+#define SOLID_CELL_COLUMNS_STRIDE        (MAP_HEIGHT + 2)
+// Plus a spare word, so any span can be read from a pair of words:
+#define SOLID_CELLS_NUM_WORDS            ((SOLID_CELLS_STRIDE * (MAP_HEIGHT + 2) + 31) / 32 + 1)
+#define SOLID_CELL_BIT_INDEX(cell)       (((cell).y + 1) * SOLID_CELLS_STRIDE + (cell).x + 1)
+#define SOLID_CELL_COLUMN_BIT_INDEX(cell) (((cell).x + 1) * SOLID_CELL_COLUMNS_STRIDE + (cell).y + 1)
+#define MAX_SOLID_CELL_SPAN              31  // Cells per "get_solid_cell_span".
+#define BUILDER_TURNS_PER_ROW            2  // When carving a winding path.
+#define MAX_ROOMS                        8  // Per rooms-and-corridors location.
+// One per pair of rooms:
+#define MAX_ROOM_LINKS                   (MAX_ROOMS * (MAX_ROOMS - 1) / 2)
+#define ROOM_PLACEMENT_ATTEMPTS          4  // Per room, before giving up on it.
+#define LOOT_CHANCE                      25  // 1 in X carved cells holds loot.
+#define NUM_LEVEL_BANDS                  4
+#define MANHATTAN_DISTANCE(a, b)         (abs((a).x - (b).x) + abs((a).y - (b).y))
+// Map width (and height) in saves by older versions:
+#define LEGACY_MAP_WIDTH                 10
 #define RANDOM_POINT_NORTH               GPoint(rand() % MAP_WIDTH, 0)
 #define RANDOM_POINT_SOUTH               GPoint(rand() % MAP_WIDTH, MAP_HEIGHT - 1)
 #define RANDOM_POINT_EAST                GPoint(MAP_WIDTH - 1, rand() % MAP_HEIGHT)
@@ -185,7 +305,7 @@ enum {
 #define SCREEN_WIDTH                     144
 #define SCREEN_HEIGHT                    168
 #define SCREEN_CENTER_POINT_X            (SCREEN_WIDTH / 2)
-#define SCREEN_CENTER_POINT_Y            (SCREEN_HEIGHT / 2 - STATUS_BAR_HEIGHT * 0.75)
+#define SCREEN_CENTER_POINT_Y            (SCREEN_HEIGHT / 2 - STATUS_BAR_HEIGHT * 3 / 4)
 #define SCREEN_CENTER_POINT              GPoint(SCREEN_CENTER_POINT_X, SCREEN_CENTER_POINT_Y)
 #define STATUS_BAR_HEIGHT                16  // Top and bottom status bars.
 #define FULL_SCREEN_FRAME                GRect(0, STATUS_BAR_HEIGHT, SCREEN_WIDTH, SCREEN_HEIGHT - STATUS_BAR_HEIGHT)
@@ -204,14 +324,23 @@ enum {
 #define GRAPHICS_FRAME_HEIGHT            (SCREEN_HEIGHT - 2 * STATUS_BAR_HEIGHT)
 #define MAX_VISIBILITY_DEPTH             6  // Helps determine no. of cells visible in a given line of sight.
 #define STRAIGHT_AHEAD                   (MAX_VISIBILITY_DEPTH - 1)  // Index value for "g_back_wall_coords".
+// Cells per row of "g_view_cone_solid_masks" (the view cone's widest row, plus
+// one cell to either side):
+#define VIEW_CONE_MASK_WIDTH             ((STRAIGHT_AHEAD * 2) + 3)
+#define VIEW_CONE_CELL_IS_SOLID(depth, position) ((g_view_cone_solid_masks[depth] >> ((position) + 1)) & 1)
 #define TOP_LEFT                         0  // Index value for "g_back_wall_coords".
 #define BOTTOM_RIGHT                     1  // Index value for "g_back_wall_coords".
 #define COMPASS_RADIUS                   5
 #define NO_CORNER_RADIUS                 0
 #define SMALL_CORNER_RADIUS              3
-#define NINETY_DEGREES                   (TRIG_MAX_ANGLE / 4)
-#define DEFAULT_ROTATION_RATE            (TRIG_MAX_ANGLE / 26)  // 13.8 degrees per rotation event.
-#define ELLIPSE_RADIUS_RATIO             0.4
+#define VIEW_CONE_NUM_CELLS              ((MAX_VISIBILITY_DEPTH - 1) * (MAX_VISIBILITY_DEPTH + 1))
+#define NPC_SPRITE_ATLAS_SIZE            12
+// Bytes left free when caching NPC sprites:
+#define NPC_SPRITE_MIN_FREE_HEAP         4096
+// Swapped for random colors (mages only):
+#define NPC_SPRITE_EYE_COLOR             GColorWhite
+// 0.4, rounded up so exact products aren't truncated:
+#define ELLIPSE_RADIUS_RATIO             (FIXED_POINT_ONE * 2 / 5 + 1)
 #define HEAVY_ITEMS_MENU_HEADER_STR_LEN  16
 #define ITEM_TITLE_STR_LEN               19
 #define ITEM_SUBTITLE_STR_LEN            13
@@ -228,13 +357,30 @@ enum {
 #define MULTI_CLICK_TIMEOUT              0  // milliseconds
 #define PLAYER_ACTION_REPEAT_INTERVAL    250  // milliseconds
 #define DEFAULT_TIMER_DURATION           20  // milliseconds
+// Milliseconds without player input before saving or prefetching:
+#define IDLE_WORK_DELAY                  1000
+#define BACKLIGHT_REQUEST_INTERVAL       2  // seconds (light stays on longer)
 #define DEFAULT_MAX_SMALL_INT_VALUE      100
 #define MAX_SMALL_INT_DIGITS             3
 #define MAX_LARGE_INT_DIGITS             5
 #define MAX_DEPTH                        DEFAULT_MAX_SMALL_INT_VALUE
 #define MAX_LEVEL                        DEFAULT_MAX_SMALL_INT_VALUE
 #define PLAYER_STORAGE_KEY               841
-#define LOCATION_STORAGE_KEY             (PLAYER_STORAGE_KEY + 1)
+// Where older versions saved the location (see "legacy_location_t"):
+#define LEGACY_LOCATION_STORAGE_KEY      (PLAYER_STORAGE_KEY + 1)
+// Holds STORAGE_FORMAT (older versions' saves lack it):
+#define STORAGE_FORMAT_KEY               (PLAYER_STORAGE_KEY + 2)
+#define STORAGE_FORMAT_VERSION           2
+#define STORAGE_FORMAT                   ((STORAGE_FORMAT_VERSION << 16) | (MAP_WIDTH << 8) | MAP_HEIGHT)
+#define LOCATION_HEADER_STORAGE_KEY      (PLAYER_STORAGE_KEY + 3)
+// Fixed ranges of keys, with room for the largest maps (64x64):
+#define TERRAIN_STORAGE_KEY              (PLAYER_STORAGE_KEY + 4)
+#define MAX_TERRAIN_STORAGE_KEYS         4
+#define SPECIAL_CELLS_STORAGE_KEY        (TERRAIN_STORAGE_KEY + MAX_TERRAIN_STORAGE_KEYS)
+#define MAX_SPECIAL_CELLS_STORAGE_KEYS   4
+// Live NPCs only, packed into as few keys as possible:
+#define FIRST_NPC_STORAGE_KEY            (SPECIAL_CELLS_STORAGE_KEY + MAX_SPECIAL_CELLS_STORAGE_KEYS)
+#define NPCS_PER_STORAGE_KEY             (PERSIST_DATA_MAX_LENGTH / sizeof(npc_t))
 #define ANIMATED                         true
 #define NOT_ANIMATED                     false
 #define NUM_BACKGROUND_COLOR_SCHEMES     8
@@ -242,6 +388,37 @@ enum {
 #define RANDOM_COLOR                     GColorFromRGB(rand() % 256, rand() % 256, rand() % 256)
 #define RANDOM_DARK_COLOR                GColorFromRGB(rand() % 128, rand() % 128, rand() % 128)
 #define RANDOM_BRIGHT_COLOR              GColorFromRGB(rand() % 128 + 128, rand() % 128 + 128, rand() % 128 + 128)
+#define SCENE_HASH_OFFSET_BASIS          2166136261u  // 32-bit FNV-1a.
+#define SCENE_HASH_PRIME                 16777619u
+#define HASH_COMBINE(hash, value)        (((hash) ^ (uint8_t) (value)) * SCENE_HASH_PRIME)
+#define FIXED_POINT_SHIFT                16  // Q16.16 (see "fixed_t").
+#define FIXED_POINT_ONE                  (1 << FIXED_POINT_SHIFT)
+#define INT_TO_FIXED(n)                  ((fixed_t) (n) * FIXED_POINT_ONE)
+// Truncates toward zero, like a float cast:
+#define FIXED_TO_INT(f)                  ((f) / FIXED_POINT_ONE)
+#ifdef PROFILE_FRAME_STAGES
+#define PROFILER_NUM_FRAMES              16  // Frames per logged report.
+#define PROFILE_STAGE_START()            (g_profiler_stage_start = get_time_in_ms())
+#define PROFILE_STAGE_END(stage)         (g_profiler_stage_times[stage] += (uint16_t) (get_time_in_ms() - g_profiler_stage_start))
+#else
+#define PROFILE_STAGE_START()
+#define PROFILE_STAGE_END(stage)
+#endif
+#ifdef BENCHMARK_RENDERING
+// Benchmark maps are tiled to fill larger maps:
+#define BENCHMARK_MAP_SIZE               10
+// The last bucket also counts anything larger:
+#define BENCHMARK_HISTOGRAM_SIZE         128
+#define BENCHMARK_LOOT                   SHIELD
+
+// Count drawing calls (a macro isn't expanded again within its own expansion):
+#define graphics_fill_rect(...)            (++g_benchmark_draw_calls, graphics_fill_rect(__VA_ARGS__))
+#define graphics_fill_circle(...)          (++g_benchmark_draw_calls, graphics_fill_circle(__VA_ARGS__))
+#define graphics_draw_line(...)            (++g_benchmark_draw_calls, graphics_draw_line(__VA_ARGS__))
+#define gpath_draw_filled(...)             (++g_benchmark_draw_calls, gpath_draw_filled(__VA_ARGS__))
+#define gpath_draw_outline(...)            (++g_benchmark_draw_calls, gpath_draw_outline(__VA_ARGS__))
+#define graphics_capture_frame_buffer(...) (++g_benchmark_draw_calls, graphics_capture_frame_buffer(__VA_ARGS__))
+#endif
 
 static const GPathInfo COMPASS_PATH_INFO = {
   .num_points = 4,
@@ -251,6 +428,32 @@ static const GPathInfo COMPASS_PATH_INFO = {
                          {-3, -3}}
 };
 
+// Per-direction unit vectors and turns (indexed by NORTH, SOUTH, EAST, WEST):
+static const GPoint g_direction_vectors[NUM_DIRECTIONS] = {
+  {0, -1},
+  {0, 1},
+  {1, 0},
+  {-1, 0}
+};
+static const int8_t g_directions_to_the_left[NUM_DIRECTIONS] = {
+  WEST,
+  EAST,
+  NORTH,
+  SOUTH
+};
+static const int8_t g_directions_to_the_right[NUM_DIRECTIONS] = {
+  EAST,
+  WEST,
+  SOUTH,
+  NORTH
+};
+static const int8_t g_opposite_directions[NUM_DIRECTIONS] = {
+  SOUTH,
+  NORTH,
+  WEST,
+  EAST
+};
+
 static const char *const g_narration_strings[] = {
   "Evil wizards stole the Elderstone and sundered it, creating a hundred Pebbles of Power.",
   "You have entered the wizards' vast underground lair to recover the Pebbles and save the realm.",
@@ -318,6 +521,56 @@ static const char *const g_item_names[] = {
   "H. Armor",
 };
 
+#ifdef PROFILE_FRAME_STAGES
+static const char *const g_profiler_stage_names[] = {
+  "scene cache",
+  "floor/ceiling",
+  "visibility",
+  "walls",
+  "cell contents",
+  "attack slash",
+  "spell beams",
+  "status meters",
+  "compass",
+};
+#endif
+
+#ifdef BENCHMARK_RENDERING
+// '#' = SOLID, '.' = EMPTY, 'E' = entrance, 'X' = EXIT, 'L' = loot, 'N' = NPC:
+static const char *const g_benchmark_maps[] = {
+  "##########"
+  "E........#"
+  "#.######.#"
+  "#.#L...#.#"
+  "#.#.##.#.#"
+  "#.#.##...#"
+  "#.#.######"
+  "#...#....#"
+  "###...##.X"
+  "##########",
+  "E........."
+  ".........."
+  "...#......"
+  ".........."
+  "......#..."
+  "....X....."
+  "..#......."
+  ".........."
+  ".L...#...."
+  "..........",
+  "E.#.#.#.#."
+  "N..N..N..N"
+  "#.#.#.#.#."
+  "N..N..N..N"
+  "#.#L#.#.#."
+  "N..N..N..N"
+  "#.#.#.#.#."
+  "N..N..N..N"
+  "#.#.#.#.#X"
+  "N..N..N..N",
+};
+#endif
+
 static const char *const g_magic_type_names[] = {
   "",
   " of Thunder",
@@ -333,6 +586,8 @@ static const char *const g_magic_type_names[] = {
   Structure Definitions
 *******************************************************************************/
 
+typedef int32_t fixed_t;  // Signed Q16.16 value (Pebble has no FPU).
+
 typedef struct HeavyItem {
   int8_t type,
          infused_pebble,
@@ -359,16 +614,168 @@ typedef struct NonPlayerCharacter {
          power,
          physical_defense,
          magical_defense;
-  uint8_t status_effects[NUM_STATUS_EFFECTS];
+  // Low 16 bits of "g_location->tick_count" at which effects wear off:
+  uint16_t status_effect_expiry_ticks[NUM_STATUS_EFFECTS];
 } __attribute__((__packed__)) npc_t;
 
+typedef struct LegacyNonPlayerCharacter {
+  GPoint position;
+  int8_t type,
+         item,
+         health,
+         power,
+         physical_defense,
+         magical_defense;
+  uint8_t status_effects[NUM_STATUS_EFFECTS];  // Ticks remaining.
+} __attribute__((__packed__)) legacy_npc_t;  // As saved by older versions.
+
+typedef struct WallColumn {
+  uint8_t top,
+          bottom,
+          first_dot,
+          dot_spacing,
+          color_index;
+} __attribute__((__packed__)) wall_column_t;
+
+typedef struct WallQuad {
+  int16_t x;  // Leftmost on-screen column.
+  uint8_t num_columns;
+  uint16_t first_column;  // Index value for "g_wall_columns".
+} __attribute__((__packed__)) wall_quad_t;
+
+typedef struct NpcSprite {
+  GBitmap *bitmap;
+  int8_t npc_type,  // NONE if the atlas slot is free.
+         depth,
+         frame;     // Animation frame (0 or 1).
+  int16_t x_offset,  // Top-left corner relative to the NPC's floor point.
+          y_offset;
+  uint16_t last_used;
+} __attribute__((__packed__)) npc_sprite_t;
+
+typedef struct SpecialCell {
+  uint8_t x,
+          y;
+  int8_t type;  // EXIT or an item type (for loot).
+} __attribute__((__packed__)) special_cell_t;
+
 typedef struct Location {
-  int8_t map[MAP_WIDTH][MAP_HEIGHT],
+  GPoint entrance;
+  uint32_t tick_count;  // Ticks handled since the location was created.
+  npc_t npcs[MAX_NPCS_AT_ONE_TIME];  // NPC pool (free slots have type NONE).
+  int8_t num_active_npcs,
+         first_free_npc,  // Head of the free list (NONE if the pool is full).
+         active_npcs[MAX_NPCS_AT_ONE_TIME];  // Slot indices of live NPCs.
+  // Next free slot (for free slots) or index in "active_npcs" (for live NPCs):
+  int8_t npc_links[MAX_NPCS_AT_ONE_TIME];
+  int8_t floor_color_scheme,
+         wall_color_scheme;
+  int16_t num_special_cells;
+  // Last, since their sizes vary with the map's (keeping the GPoints above
+  // aligned):
+  uint8_t terrain[TERRAIN_SIZE];  // Terrain codes, packed in row order.
+  special_cell_t special_cells[MAX_SPECIAL_CELLS];  // By SPECIAL_CELL_INDEX.
+} __attribute__((__packed__)) location_t;
+
+typedef struct LocationHeader {
+  int8_t floor_color_scheme,
+         wall_color_scheme;
+  GPoint entrance;
+  uint32_t tick_count;
+  int16_t num_special_cells;
+  int8_t num_active_npcs;
+} __attribute__((__packed__)) location_header_t;  // As saved with a location.
+
+typedef struct LegacyLocation {
+  int8_t map[LEGACY_MAP_WIDTH][LEGACY_MAP_WIDTH],
          floor_color_scheme,
          wall_color_scheme;
   GPoint entrance;
-  npc_t npcs[MAX_NPCS_AT_ONE_TIME];
-} __attribute__((__packed__)) location_t;
+  legacy_npc_t npcs[LEGACY_MAX_NPCS_AT_ONE_TIME];
+} __attribute__((__packed__)) legacy_location_t;  // As saved by older versions.
+
+typedef struct LevelBand {
+  int8_t min_depth,  // First depth at which the band's parameters apply.
+         layout,
+         max_rooms,  // Up to MAX_ROOMS.
+         min_room_size,  // Width and height, in cells.
+         max_room_size,
+         max_loops,  // Extra corridors between already-connected rooms.
+         loop_chance;  // Percent chance of adding each possible loop.
+} __attribute__((__packed__)) level_band_t;
+
+// Level generation parameters per depth band, in order of increasing depth:
+static const level_band_t g_level_bands[NUM_LEVEL_BANDS] = {
+  {1, WINDING_PATH_LAYOUT, 0, 0, 0, 0, 0},
+  {5, ROOMS_AND_CORRIDORS_LAYOUT, 4, 2, 4, 1, 25},
+  {25, ROOMS_AND_CORRIDORS_LAYOUT, 6, 2, 3, 2, 50},
+  {60, ROOMS_AND_CORRIDORS_LAYOUT, MAX_ROOMS, 1, 3, 4, 75},
+};
+
+typedef struct ViewConeCell {
+  int8_t dx,  // Offset from the player's position.
+         dy,
+         depth,     // Index values for "g_back_wall_coords".
+         position;
+} __attribute__((__packed__)) view_cone_cell_t;
+
+// Cells the player can see, per direction, in back-to-front drawing order
+// (each depth: straight ahead, then from the outermost pair of side cells
+// inward). Written out for MAX_VISIBILITY_DEPTH == 6:
+#if MAX_VISIBILITY_DEPTH != 6
+#error "g_view_cone must be rewritten for the new MAX_VISIBILITY_DEPTH."
+#endif
+static const view_cone_cell_t g_view_cone[NUM_DIRECTIONS]
+                                         [VIEW_CONE_NUM_CELLS] = {
+  {  // NORTH:
+    {0, -4, 4, 5}, {-5, -4, 4, 0}, {5, -4, 4, 10}, {-4, -4, 4, 1},
+    {4, -4, 4, 9}, {-3, -4, 4, 2}, {3, -4, 4, 8}, {-2, -4, 4, 3},
+    {2, -4, 4, 7}, {-1, -4, 4, 4}, {1, -4, 4, 6},
+    {0, -3, 3, 5}, {-4, -3, 3, 1}, {4, -3, 3, 9}, {-3, -3, 3, 2},
+    {3, -3, 3, 8}, {-2, -3, 3, 3}, {2, -3, 3, 7}, {-1, -3, 3, 4},
+    {1, -3, 3, 6},
+    {0, -2, 2, 5}, {-3, -2, 2, 2}, {3, -2, 2, 8}, {-2, -2, 2, 3},
+    {2, -2, 2, 7}, {-1, -2, 2, 4}, {1, -2, 2, 6},
+    {0, -1, 1, 5}, {-2, -1, 1, 3}, {2, -1, 1, 7}, {-1, -1, 1, 4},
+    {1, -1, 1, 6},
+    {0, 0, 0, 5}, {-1, 0, 0, 4}, {1, 0, 0, 6}
+  },
+  {  // SOUTH:
+    {0, 4, 4, 5}, {5, 4, 4, 0}, {-5, 4, 4, 10}, {4, 4, 4, 1}, {-4, 4, 4, 9},
+    {3, 4, 4, 2}, {-3, 4, 4, 8}, {2, 4, 4, 3}, {-2, 4, 4, 7}, {1, 4, 4, 4},
+    {-1, 4, 4, 6},
+    {0, 3, 3, 5}, {4, 3, 3, 1}, {-4, 3, 3, 9}, {3, 3, 3, 2}, {-3, 3, 3, 8},
+    {2, 3, 3, 3}, {-2, 3, 3, 7}, {1, 3, 3, 4}, {-1, 3, 3, 6},
+    {0, 2, 2, 5}, {3, 2, 2, 2}, {-3, 2, 2, 8}, {2, 2, 2, 3}, {-2, 2, 2, 7},
+    {1, 2, 2, 4}, {-1, 2, 2, 6},
+    {0, 1, 1, 5}, {2, 1, 1, 3}, {-2, 1, 1, 7}, {1, 1, 1, 4}, {-1, 1, 1, 6},
+    {0, 0, 0, 5}, {1, 0, 0, 4}, {-1, 0, 0, 6}
+  },
+  {  // EAST:
+    {4, 0, 4, 5}, {4, -5, 4, 0}, {4, 5, 4, 10}, {4, -4, 4, 1}, {4, 4, 4, 9},
+    {4, -3, 4, 2}, {4, 3, 4, 8}, {4, -2, 4, 3}, {4, 2, 4, 7}, {4, -1, 4, 4},
+    {4, 1, 4, 6},
+    {3, 0, 3, 5}, {3, -4, 3, 1}, {3, 4, 3, 9}, {3, -3, 3, 2}, {3, 3, 3, 8},
+    {3, -2, 3, 3}, {3, 2, 3, 7}, {3, -1, 3, 4}, {3, 1, 3, 6},
+    {2, 0, 2, 5}, {2, -3, 2, 2}, {2, 3, 2, 8}, {2, -2, 2, 3}, {2, 2, 2, 7},
+    {2, -1, 2, 4}, {2, 1, 2, 6},
+    {1, 0, 1, 5}, {1, -2, 1, 3}, {1, 2, 1, 7}, {1, -1, 1, 4}, {1, 1, 1, 6},
+    {0, 0, 0, 5}, {0, -1, 0, 4}, {0, 1, 0, 6}
+  },
+  {  // WEST:
+    {-4, 0, 4, 5}, {-4, 5, 4, 0}, {-4, -5, 4, 10}, {-4, 4, 4, 1},
+    {-4, -4, 4, 9}, {-4, 3, 4, 2}, {-4, -3, 4, 8}, {-4, 2, 4, 3},
+    {-4, -2, 4, 7}, {-4, 1, 4, 4}, {-4, -1, 4, 6},
+    {-3, 0, 3, 5}, {-3, 4, 3, 1}, {-3, -4, 3, 9}, {-3, 3, 3, 2},
+    {-3, -3, 3, 8}, {-3, 2, 3, 3}, {-3, -2, 3, 7}, {-3, 1, 3, 4},
+    {-3, -1, 3, 6},
+    {-2, 0, 2, 5}, {-2, 3, 2, 2}, {-2, -3, 2, 8}, {-2, 2, 2, 3},
+    {-2, -2, 2, 7}, {-2, 1, 2, 4}, {-2, -1, 2, 6},
+    {-1, 0, 1, 5}, {-1, 2, 1, 3}, {-1, -2, 1, 7}, {-1, 1, 1, 4},
+    {-1, -1, 1, 6},
+    {0, 0, 0, 5}, {0, 1, 0, 4}, {0, -1, 0, 6}
+  }
+};
 
 /*******************************************************************************
   Global Variables
@@ -378,18 +785,53 @@ Window *g_windows[NUM_WINDOWS];
 MenuLayer *g_menu_layers[NUM_MENUS];
 TextLayer *g_narration_text_layer;
 StatusBarLayer *g_status_bars[NUM_WINDOWS];
-AppTimer *g_attack_timer,
-         *g_player_spell_timer,
-         *g_enemy_spell_timer;
+Layer *g_scene_layer,
+      *g_overlay_layer;
+AppTimer *g_animation_timer,  // NULL when nothing is animating.
+         *g_idle_timer;  // NULL when no background work is scheduled.
 GPoint g_back_wall_coords[MAX_VISIBILITY_DEPTH - 1]
                          [(STRAIGHT_AHEAD * 2) + 1]
                          [2];
+wall_quad_t g_wall_quads[MAX_VISIBILITY_DEPTH - 1]
+                       [(STRAIGHT_AHEAD * 2) + 1]
+                       [NUM_WALL_SIDES];
+wall_column_t *g_wall_columns;
+npc_sprite_t g_npc_sprites[NPC_SPRITE_ATLAS_SIZE];
+uint16_t g_npc_sprite_clock;
+bool g_cell_is_visible[MAX_VISIBILITY_DEPTH - 1][(STRAIGHT_AHEAD * 2) + 1];
+// Index values for "g_location->npcs" (NONE if vacant):
+int8_t g_npc_grid[MAP_WIDTH][MAP_HEIGHT];
+// Steps from the player (NONE if unreachable):
+int16_t g_distance_field[MAP_WIDTH][MAP_HEIGHT];
+// Cells awaiting a visit while "g_distance_field" is computed (or during
+// "is_connected"), stored as indices (y * MAP_WIDTH + x). Too big for the stack
+// on large maps:
+int16_t g_distance_field_queue[MAP_WIDTH * MAP_HEIGHT];
+// Cells reached by "is_connected" (a bit per index, as above):
+uint32_t g_flood_fill_cells[(MAP_WIDTH * MAP_HEIGHT + 31) / 32];
+// Player position when "g_distance_field" was computed:
+GPoint g_distance_field_origin;
+bool g_distance_field_is_current;  // "False" after any map change.
+// One bit per cell, with a solid border, row by row (see SOLID_CELL_BIT_INDEX)
+// and column by column (see SOLID_CELL_COLUMN_BIT_INDEX):
+uint32_t g_solid_cells[SOLID_CELLS_NUM_WORDS],
+         g_solid_cell_columns[SOLID_CELLS_NUM_WORDS];
+// Solid cells in each row of the view cone, as of the last call to
+// "find_visible_cells" (see VIEW_CONE_CELL_IS_SOLID):
+uint16_t g_view_cone_solid_masks[MAX_VISIBILITY_DEPTH];
+// X-coord. of the first cell in each cell's run of non-solid cells along its
+// row (NONE if solid), and Y-coord. of the first in its run along its column:
+int8_t g_horizontal_runs[MAP_WIDTH][MAP_HEIGHT],
+       g_vertical_runs[MAP_WIDTH][MAP_HEIGHT];
 GPath *g_compass_path;
+GBitmap *g_floor_and_ceiling_bitmap,
+        *g_scene_bitmap;
 GColor g_magic_type_colors[NUM_PEBBLE_TYPES][2],
        g_background_colors[NUM_BACKGROUND_COLOR_SCHEMES]
                           [NUM_BACKGROUND_COLORS_PER_SCHEME];
 player_t *g_player;
-location_t *g_location;
+location_t *g_location,
+           *g_next_location;  // Prefetched (NULL if there's no room for it).
 uint8_t g_current_window,
         g_current_narration,
         g_current_selection,
@@ -398,8 +840,36 @@ uint8_t g_current_window,
         g_attack_slash_y1,
         g_attack_slash_y2;
 int8_t g_player_current_spell_animation,
-       g_enemy_current_spell_animation;
-bool g_player_is_attacking;
+       g_enemy_current_spell_animation,
+       g_enemy_spell_caster,  // Index value for "g_location->npcs".
+       g_next_location_direction,  // Player's, on entering "g_next_location".
+       g_floor_and_ceiling_color_scheme;
+uint32_t g_scene_hash,
+         g_overlay_hash,
+         g_power_counters[NUM_POWER_COUNTERS];
+time_t g_last_backlight_request;
+bool g_player_is_attacking,
+     g_scene_is_cached,
+     g_scene_has_random_colors,  // "True" if a mage was drawn.
+     g_next_location_is_ready,  // "False" if not prefetched for current depth.
+     g_location_needs_saving;  // "True" until saved to persistent storage.
+#ifdef PROFILE_FRAME_STAGES
+uint16_t g_profiler_frames[PROFILER_NUM_FRAMES][NUM_PROFILER_STAGES],
+         g_profiler_stage_times[NUM_PROFILER_STAGES],
+         g_profiler_stage_start;
+uint8_t g_profiler_frame_index;
+#endif
+#ifdef BENCHMARK_RENDERING
+location_t *g_benchmark_saved_location;
+GPoint g_benchmark_saved_position;
+int8_t g_benchmark_saved_direction,
+       g_benchmark_map;  // NONE when no benchmark is running.
+int32_t g_benchmark_pose;
+uint16_t g_benchmark_draw_calls,
+         g_benchmark_num_frames,
+         g_benchmark_frame_times[BENCHMARK_HISTOGRAM_SIZE],
+         g_benchmark_frame_draw_calls[BENCHMARK_HISTOGRAM_SIZE];
+#endif
 
 /*******************************************************************************
   Function Declarations
@@ -408,6 +878,13 @@ bool g_player_is_attacking;
 int8_t set_player_direction(const int8_t new_direction);
 bool move_player(const int8_t direction);
 void move_npc(npc_t *const npc, const int8_t direction);
+void remove_npc(npc_t *const npc);
+uint8_t get_npc_status_effect(const npc_t *const npc,
+                              const int8_t status_effect);
+void add_npc_status_effect(npc_t *const npc,
+                           const int8_t status_effect,
+                           const uint8_t duration);
+void sweep_npc_status_effects(void);
 int8_t damage_player(int8_t damage);
 int8_t damage_npc(npc_t *const npc, int8_t damage);
 int8_t cast_spell_on_npc(npc_t *const npc,
@@ -419,19 +896,53 @@ bool add_new_npc(const int8_t npc_type, const GPoint position);
 GPoint get_cell_farther_away(const GPoint reference_point,
                              const int8_t direction,
                              const int8_t distance);
-int8_t get_pursuit_direction(const GPoint pursuer, const GPoint pursuee);
-int8_t get_direction_to_the_left(const int8_t reference_direction);
-int8_t get_direction_to_the_right(const int8_t reference_direction);
-int8_t get_opposite_direction(const int8_t direction);
+void update_distance_field(void);
+int8_t get_distance_field_direction(const GPoint position, const bool fleeing);
 int8_t get_nth_item_type(const int8_t n);
 int8_t get_num_pebble_types_owned(void);
 int8_t get_inventory_row_for_pebble(const int8_t pebble_type);
 heavy_item_t *get_heavy_item_equipped_at(const int8_t equip_target);
+int8_t get_terrain(const location_t *const location, const GPoint cell);
+void set_terrain(location_t *const location,
+                 const GPoint cell,
+                 const int8_t terrain);
+int16_t find_special_cell_slot(const location_t *const location,
+                               const GPoint cell);
+int16_t find_special_cell(const location_t *const location,
+                          const GPoint cell);
+int8_t get_location_cell_type(const location_t *const location,
+                              const GPoint cell);
 int8_t get_cell_type(const GPoint cell);
-void set_cell_type(GPoint cell, const int8_t type);
+bool is_solid(const GPoint cell);
+uint32_t get_solid_cell_span(const GPoint first,
+                             const bool vertical,
+                             const int8_t length);
+uint8_t get_open_neighbors(const GPoint cell);
+bool set_location_cell_type(location_t *const location,
+                            const GPoint cell,
+                            const int8_t type);
+bool set_cell_type(GPoint cell, const int8_t type);
 npc_t *get_npc_at(const GPoint cell);
+void link_npc_pool(location_t *const location);
+void init_npc_pool(void);
+npc_t *allocate_npc(void);
+bool write_storage_range(const uint32_t first_key,
+                         const void *data,
+                         const int16_t size);
+void read_storage_range(const uint32_t first_key,
+                        void *data,
+                        const int16_t size);
+bool save_location(void);
+void save_game(void);
+bool load_location(void);
 char *get_stat_title_str(const int8_t stat_index);
+void update_line_of_sight_runs(const GPoint cell);
+void init_map_caches(void);
+void clear_location_map(location_t *const location);
+void clear_map(void);
+bool in_line_of_sight(const GPoint viewer, const GPoint target);
 bool occupiable(const GPoint cell);
+uint8_t get_occupiable_neighbors(const GPoint cell);
 int8_t show_narration(const int8_t narration);
 int8_t show_window(const int8_t window_index, const bool animated);
 static void main_menu_draw_header_callback(GContext *ctx,
@@ -499,34 +1010,83 @@ static int16_t menu_get_header_height_callback(MenuLayer *menu_layer,
 static uint16_t menu_get_num_rows_callback(MenuLayer *menu_layer,
                                            uint16_t section_index,
                                            void *data);
+uint32_t get_scene_hash(void);
+uint32_t get_overlay_hash(void);
 void draw_scene(Layer *layer, GContext *ctx);
+void draw_overlay(Layer *layer, GContext *ctx);
+void keep_backlight_on(void);
+#ifdef LOG_FRAME_CHECKSUMS
+void log_frame_checksum(GContext *ctx);
+#endif
+#if defined(PROFILE_FRAME_STAGES) || defined(BENCHMARK_RENDERING)
+uint16_t get_time_in_ms(void);
+#endif
+#ifdef PROFILE_FRAME_STAGES
+void end_profiled_frame(void);
+#endif
+#ifdef BENCHMARK_RENDERING
+void start_benchmark(void);
+void end_benchmark(void);
+void load_benchmark_map(const int8_t map);
+bool set_next_benchmark_pose(void);
+void draw_benchmark_frame(Layer *layer, GContext *ctx);
+void log_benchmark_results(void);
+uint8_t get_histogram_percentile(const uint16_t *const histogram,
+                                 const uint16_t num_samples,
+                                 const uint8_t percentile);
+static void benchmark_timer_callback(void *data);
+#endif
+bool copy_scene(GContext *ctx, const bool restore);
+uint16_t get_view_cone_solid_mask(const int8_t depth);
+void find_visible_cells(void);
 void draw_floor_and_ceiling(GContext *ctx);
+void draw_cell(GContext *ctx,
+               const GPoint cell,
+               const int8_t depth,
+               const int8_t position);
 void draw_cell_walls(GContext *ctx,
-                     const GPoint cell,
                      const int8_t depth,
                      const int8_t position);
 void draw_cell_contents(GContext *ctx,
                         const GPoint cell,
                         const int8_t depth,
                         const int8_t position);
-void draw_shaded_quad(GContext *ctx,
-                      const GPoint upper_left,
-                      const GPoint lower_left,
-                      const GPoint upper_right,
-                      const GPoint lower_right,
-                      const GPoint shading_ref);
+void draw_npc(GContext *ctx,
+              const int8_t npc_type,
+              const int8_t depth,
+              const GPoint floor_center_point,
+              const uint8_t drawing_unit,
+              const GColor eye_color);
+bool draw_npc_sprite(GContext *ctx,
+                     const int8_t npc_type,
+                     const int8_t depth,
+                     const GPoint floor_center_point,
+                     const uint8_t drawing_unit);
+npc_sprite_t *init_npc_sprite(GContext *ctx,
+                              const int8_t npc_type,
+                              const int8_t depth,
+                              const int8_t frame,
+                              const GPoint floor_center_point,
+                              const uint8_t drawing_unit);
+npc_sprite_t *evict_npc_sprite(void);
+void draw_shaded_wall(GContext *ctx,
+                      const int8_t depth,
+                      const int8_t position,
+                      const int8_t side);
 void draw_status_meter(GContext *ctx,
                        GPoint origin,
-                       const float ratio);
+                       const fixed_t ratio);
 void fill_ellipse(GContext *ctx,
                   const GPoint center,
                   const uint8_t h_radius,
                   const uint8_t v_radius,
                   const GColor color);
-static void player_spell_timer_callback(void *data);
-static void enemy_spell_timer_callback(void *data);
-static void attack_timer_callback(void *data);
+void schedule_animation_frame(void);
+void schedule_idle_work(void);
+static void idle_timer_callback(void *data);
+static void animation_timer_callback(void *data);
 static void graphics_window_appear(Window *window);
+static void graphics_window_disappear(Window *window);
 void graphics_up_single_repeating_click(ClickRecognizerRef recognizer,
                                         void *context);
 void graphics_up_multi_click(ClickRecognizerRef recognizer, void *context);
@@ -538,6 +1098,7 @@ void graphics_select_single_repeating_click(ClickRecognizerRef recognizer,
 void graphics_click_config_provider(void *context);
 void narration_single_click(ClickRecognizerRef recognizer, void *context);
 void narration_click_config_provider(void *context);
+static void tick_handler(struct tm *tick_time, TimeUnits units_changed);
 void app_focus_handler(const bool in_focus);
 void equip_heavy_item(heavy_item_t *const item);
 void unequip_heavy_item(heavy_item_t *const heavy_item);
@@ -545,9 +1106,41 @@ void unequip_item_at(const int8_t equip_target);
 void set_player_minor_stats(void);
 void init_player(void);
 void init_npc(npc_t *const npc, const int8_t type, const GPoint position);
+void init_npc_struct(npc_t *const npc,
+                     const int8_t type,
+                     const GPoint position,
+                     const uint32_t tick_count);
 void init_heavy_item(heavy_item_t *const item, const int8_t n);
+bool get_wall_corners(const int8_t depth,
+                      const int8_t position,
+                      const int8_t side,
+                      GPoint *const upper_left,
+                      GPoint *const lower_left,
+                      GPoint *const upper_right);
+void init_wall_columns(const wall_quad_t *const quad,
+                       const GPoint upper_left,
+                       const GPoint lower_left,
+                       const GPoint upper_right);
 void init_wall_coords(void);
+void init_floor_and_ceiling_bitmap(void);
+void carve_cell(location_t *const location, const GPoint cell);
+void carve_corridor(location_t *const location,
+                    GPoint from,
+                    const GPoint to);
+GPoint carve_winding_path(location_t *const location,
+                          const GPoint exit_position,
+                          const int8_t direction);
+int8_t find_room_set(int8_t *const sets, int8_t room);
+bool is_connected(const location_t *const location,
+                  const GPoint from,
+                  const GPoint to);
+GPoint carve_rooms_and_corridors(location_t *const location,
+                                 const level_band_t *const band,
+                                 const GPoint exit_position,
+                                 const int8_t direction);
+int8_t generate_location(location_t *const location, GPoint *const entrance);
 void init_location(void);
+void prefetch_next_location(void);
 void init_window(const int8_t window_index);
 void deinit_window(const int8_t window_index);
 void init(void);
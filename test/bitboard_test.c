@@ -0,0 +1,398 @@
+/*******************************************************************************
+   Filename: bitboard_test.c
+
+Description: Checks the solid-cell bitboards' word-level queries against
+             cell-by-cell "is_solid" lookups on random maps:
+
+               - "get_solid_cell_span" for every run of up to
+                 MAX_SOLID_CELL_SPAN cells along every row and column (and
+                 beyond the border), in both bitboards.
+               - "get_open_neighbors" and "get_occupiable_neighbors" for every
+                 cell, with NPCs scattered about.
+               - "get_view_cone_solid_mask" for every depth, from every cell,
+                 facing every direction.
+               - After random edits via "set_cell_type", both bitboards must
+                 equal a rebuild from scratch.
+
+             Then (with "bench") times the mask queries against the per-cell
+             paths ("get_cell_type" and "is_solid").
+
+               bitboard_test [bench] [seed]
+*******************************************************************************/
+
+#include "host.h"
+
+#define NUM_TEST_MAPS                    20
+#define SOLID_CHANCE                     40  // Percent of cells made solid.
+#define NUM_TEST_NPCS                    8
+#define NUM_EDITS_PER_MAP                200
+#define BENCHMARK_REPS                   200
+
+/*******************************************************************************
+   Function: get_time_in_ns
+
+Description: Reads the host's monotonic clock.
+
+     Inputs: None.
+
+    Outputs: Nanoseconds since an arbitrary starting point.
+*******************************************************************************/
+static uint64_t get_time_in_ns(void) {
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (uint64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+/*******************************************************************************
+   Function: load_random_map
+
+Description: Replaces the current location with random terrain (via
+             "set_cell_type", so the bitboards are kept up to date
+             incrementally) and scatters a few NPCs over it.
+
+     Inputs: None.
+
+    Outputs: None.
+*******************************************************************************/
+static void load_random_map(void) {
+  int16_t i;
+
+  for (i = 0; i < MAX_NPCS_AT_ONE_TIME; ++i) {
+    g_location->npcs[i].type = NONE;
+  }
+  init_npc_pool();
+  clear_map();
+  g_player->position = GPoint(NONE, NONE);
+  for (i = 0; i < MAP_WIDTH * MAP_HEIGHT; ++i) {
+    set_cell_type(GPoint(i % MAP_WIDTH, i / MAP_WIDTH),
+                  rand() % 100 < SOLID_CHANCE ? SOLID : EMPTY);
+  }
+  for (i = 0; i < NUM_TEST_NPCS; ++i) {
+    add_new_npc(rand() % (NUM_NPC_TYPES - 1),
+                GPoint(rand() % MAP_WIDTH, rand() % MAP_HEIGHT));
+  }
+  g_player->position = GPoint(rand() % MAP_WIDTH, rand() % MAP_HEIGHT);
+}
+
+/*******************************************************************************
+   Function: test_spans
+
+Description: Compares every span of the current map with "is_solid".
+
+     Inputs: None.
+
+    Outputs: Number of mismatched spans.
+*******************************************************************************/
+static int test_spans(void) {
+  int8_t vertical, length, i;
+  int16_t line, start;
+  int num_mismatches = 0;
+  uint32_t span, expected;
+  GPoint first;
+
+  for (vertical = 0; vertical < 2; ++vertical) {
+    for (line = -3; line < (vertical ? MAP_WIDTH : MAP_HEIGHT) + 3; ++line) {
+      for (start = -MAX_SOLID_CELL_SPAN - 1;
+           start < (vertical ? MAP_HEIGHT : MAP_WIDTH) + 3;
+           ++start) {
+        first = vertical ? GPoint(line, start) : GPoint(start, line);
+        for (length = 1; length <= MAX_SOLID_CELL_SPAN; ++length) {
+          span = get_solid_cell_span(first, vertical, length);
+          expected = 0;
+          for (i = 0; i < length; ++i) {
+            expected |= (uint32_t) is_solid(
+                          vertical ? GPoint(first.x, first.y + i) :
+                                     GPoint(first.x + i, first.y)) << i;
+          }
+          if (span != expected && num_mismatches++ == 0) {
+            printf("span (%d, %d) %s %d: %08lx, expected %08lx\n",
+                   first.x,
+                   first.y,
+                   vertical ? "south" : "east",
+                   length,
+                   (unsigned long) span,
+                   (unsigned long) expected);
+          }
+        }
+      }
+    }
+  }
+
+  return num_mismatches;
+}
+
+/*******************************************************************************
+   Function: test_neighbors
+
+Description: Compares every cell's open and occupiable neighbor masks with
+             "is_solid" and "occupiable".
+
+     Inputs: None.
+
+    Outputs: Number of mismatched masks.
+*******************************************************************************/
+static int test_neighbors(void) {
+  int8_t i;
+  int16_t x, y;
+  int num_mismatches = 0;
+  uint8_t open, occupiable_mask;
+  GPoint cell, neighbor;
+
+  for (x = 0; x < MAP_WIDTH; ++x) {
+    for (y = 0; y < MAP_HEIGHT; ++y) {
+      cell = GPoint(x, y);
+      open = occupiable_mask = 0;
+      for (i = 0; i < NUM_DIRECTIONS; ++i) {
+        neighbor = get_cell_farther_away(cell, i, 1);
+        open |= !is_solid(neighbor) << i;
+        occupiable_mask |= occupiable(neighbor) << i;
+      }
+      if ((get_open_neighbors(cell) != open ||
+           get_occupiable_neighbors(cell) != occupiable_mask) &&
+          num_mismatches++ == 0) {
+        printf("neighbors of (%d, %d): %x/%x, expected %x/%x\n",
+               x,
+               y,
+               get_open_neighbors(cell),
+               get_occupiable_neighbors(cell),
+               open,
+               occupiable_mask);
+      }
+    }
+  }
+
+  return num_mismatches;
+}
+
+/*******************************************************************************
+   Function: test_view_cone_masks
+
+Description: Compares every view cone row's solid mask with "is_solid", from
+             every cell, facing every direction.
+
+     Inputs: None.
+
+    Outputs: Number of mismatched masks.
+*******************************************************************************/
+static int test_view_cone_masks(void) {
+  int8_t direction, depth, position;
+  int16_t i;
+  int num_mismatches = 0;
+  uint16_t expected;
+  GPoint forward, rightward;
+  const GPoint player_position = g_player->position;
+  const int8_t player_direction = g_player->direction;
+
+  for (i = 0; i < MAP_WIDTH * MAP_HEIGHT; ++i) {
+    g_player->position = GPoint(i % MAP_WIDTH, i / MAP_WIDTH);
+    for (direction = 0; direction < NUM_DIRECTIONS; ++direction) {
+      g_player->direction = direction;
+      forward = g_direction_vectors[direction];
+      rightward = g_direction_vectors[g_directions_to_the_right[direction]];
+      for (depth = 0; depth < MAX_VISIBILITY_DEPTH; ++depth) {
+        expected = 0;
+        for (position = -1; position <= STRAIGHT_AHEAD * 2 + 1; ++position) {
+          expected |= is_solid(
+            GPoint(g_player->position.x + forward.x * depth +
+                     rightward.x * (position - STRAIGHT_AHEAD),
+                   g_player->position.y + forward.y * depth +
+                     rightward.y * (position - STRAIGHT_AHEAD))) <<
+            (position + 1);
+        }
+        if (get_view_cone_solid_mask(depth) != expected &&
+            num_mismatches++ == 0) {
+          printf("view cone from (%d, %d) facing %d, depth %d: %04x, "
+                 "expected %04x\n",
+                 g_player->position.x,
+                 g_player->position.y,
+                 direction,
+                 depth,
+                 get_view_cone_solid_mask(depth),
+                 expected);
+        }
+      }
+    }
+  }
+  g_player->position = player_position;
+  g_player->direction = player_direction;
+
+  return num_mismatches;
+}
+
+/*******************************************************************************
+   Function: test_edits
+
+Description: Makes random edits via "set_cell_type", then compares both
+             bitboards with a rebuild from scratch.
+
+     Inputs: None.
+
+    Outputs: One if they differ, zero if not.
+*******************************************************************************/
+static int test_edits(void) {
+  int16_t i;
+  uint32_t solid_cells[SOLID_CELLS_NUM_WORDS],
+           solid_cell_columns[SOLID_CELLS_NUM_WORDS];
+  const int8_t types[] = {SOLID, EMPTY, EXIT, SHIELD};
+
+  for (i = 0; i < NUM_EDITS_PER_MAP; ++i) {
+    set_cell_type(GPoint(rand() % MAP_WIDTH, rand() % MAP_HEIGHT),
+                  types[rand() % (sizeof(types) / sizeof(types[0]))]);
+  }
+  memcpy(solid_cells, g_solid_cells, sizeof(solid_cells));
+  memcpy(solid_cell_columns, g_solid_cell_columns, sizeof(solid_cells));
+  init_map_caches();
+  if (memcmp(solid_cells, g_solid_cells, sizeof(solid_cells)) ||
+      memcmp(solid_cell_columns,
+             g_solid_cell_columns,
+             sizeof(solid_cell_columns))) {
+    printf("edited bitboards differ from rebuilt ones\n");
+    return 1;
+  }
+
+  return 0;
+}
+
+/*******************************************************************************
+   Function: benchmark
+
+Description: Times view cone and neighbor queries over every cell and
+             direction of the current map, per cell (via "get_cell_type" and
+             via "is_solid") and via the masks, along with "find_visible_cells"
+             as a whole.
+
+     Inputs: None.
+
+    Outputs: None.
+*******************************************************************************/
+static void benchmark(void) {
+  int8_t path, direction, depth, position;
+  int16_t i, rep;
+  uint64_t start_time, times[3];
+  volatile uint32_t sink = 0;
+  uint32_t mask;
+  GPoint cell, forward, rightward;
+  const int num_views = BENCHMARK_REPS * MAP_WIDTH * MAP_HEIGHT *
+                        NUM_DIRECTIONS;
+
+  // View cone rows (every depth, as "find_visible_cells" reads them):
+  for (path = 0; path < 3; ++path) {
+    start_time = get_time_in_ns();
+    for (rep = 0; rep < BENCHMARK_REPS; ++rep) {
+      for (i = 0; i < MAP_WIDTH * MAP_HEIGHT; ++i) {
+        g_player->position = GPoint(i % MAP_WIDTH, i / MAP_WIDTH);
+        for (direction = 0; direction < NUM_DIRECTIONS; ++direction) {
+          g_player->direction = direction;
+          forward = g_direction_vectors[direction];
+          rightward = g_direction_vectors[g_directions_to_the_right
+                                            [direction]];
+          for (depth = 0; depth < MAX_VISIBILITY_DEPTH; ++depth) {
+            if (path == 2) {
+              sink += get_view_cone_solid_mask(depth);
+              continue;
+            }
+            mask = 0;
+            for (position = -1;
+                 position <= STRAIGHT_AHEAD * 2 + 1;
+                 ++position) {
+              cell = GPoint(g_player->position.x + forward.x * depth +
+                              rightward.x * (position - STRAIGHT_AHEAD),
+                            g_player->position.y + forward.y * depth +
+                              rightward.y * (position - STRAIGHT_AHEAD));
+              mask |= (path == 0 ? get_cell_type(cell) == SOLID :
+                                   is_solid(cell)) << (position + 1);
+            }
+            sink += mask;
+          }
+        }
+      }
+    }
+    times[path] = get_time_in_ns() - start_time;
+  }
+  printf("view cone rows (%d per view): get_cell_type %.1f ns/view, "
+         "is_solid %.1f ns/view, masks %.1f ns/view\n",
+         MAX_VISIBILITY_DEPTH,
+         (double) times[0] / num_views,
+         (double) times[1] / num_views,
+         (double) times[2] / num_views);
+
+  // Open neighbors:
+  for (path = 0; path < 3; ++path) {
+    start_time = get_time_in_ns();
+    for (rep = 0; rep < BENCHMARK_REPS * NUM_DIRECTIONS; ++rep) {
+      for (i = 0; i < MAP_WIDTH * MAP_HEIGHT; ++i) {
+        cell = GPoint(i % MAP_WIDTH, i / MAP_WIDTH);
+        if (path == 2) {
+          sink += get_open_neighbors(cell);
+          continue;
+        }
+        mask = 0;
+        for (direction = 0; direction < NUM_DIRECTIONS; ++direction) {
+          mask |= (path == 0 ?
+                     get_cell_type(get_cell_farther_away(cell, direction, 1)) !=
+                       SOLID :
+                     !is_solid(get_cell_farther_away(cell, direction, 1))) <<
+                  direction;
+        }
+        sink += mask;
+      }
+    }
+    times[path] = get_time_in_ns() - start_time;
+  }
+  printf("open neighbors: get_cell_type %.1f ns/cell, is_solid %.1f ns/cell, "
+         "mask %.1f ns/cell\n",
+         (double) times[0] / num_views,
+         (double) times[1] / num_views,
+         (double) times[2] / num_views);
+
+  // The whole visibility pass:
+  start_time = get_time_in_ns();
+  for (rep = 0; rep < BENCHMARK_REPS; ++rep) {
+    for (i = 0; i < MAP_WIDTH * MAP_HEIGHT; ++i) {
+      g_player->position = GPoint(i % MAP_WIDTH, i / MAP_WIDTH);
+      for (direction = 0; direction < NUM_DIRECTIONS; ++direction) {
+        g_player->direction = direction;
+        find_visible_cells();
+      }
+    }
+  }
+  printf("find_visible_cells: %.1f ns/view\n",
+         (double) (get_time_in_ns() - start_time) / num_views);
+}
+
+/*******************************************************************************
+   Function: main
+
+Description: Runs the checks on NUM_TEST_MAPS random maps, then (with "bench")
+             the timings on one more.
+
+     Inputs: argc - Number of command-line arguments.
+             argv - Command-line arguments (see the file description).
+
+    Outputs: Zero if every check passes.
+*******************************************************************************/
+int main(int argc, char **argv) {
+  int8_t map;
+  int num_failures = 0;
+
+  init();
+  srand(argc > 2 ? atoi(argv[2]) : 1);
+  for (map = 0; map < NUM_TEST_MAPS; ++map) {
+    load_random_map();
+    num_failures += test_spans() + test_neighbors() +
+                    test_view_cone_masks() + test_edits();
+  }
+  printf("bitboards: %d random maps checked, %d mismatches\n",
+         NUM_TEST_MAPS,
+         num_failures);
+  if (argc > 1 && !strcmp(argv[1], "bench")) {
+    load_random_map();
+    benchmark();
+  }
+  deinit();
+  printf("%s\n", num_failures ? "FAILED" : "passed");
+
+  return num_failures ? 1 : 0;
+}
@@ -0,0 +1,341 @@
+/*******************************************************************************
+   Filename: ellipse_test.c
+
+Description: Checks "fill_ellipse" against the ellipse's defining inequality,
+             x^2 / h_radius^2 + y^2 / v_radius^2 <= 1: every row an ellipse
+             touches must be covered by exactly one span, with nothing drawn
+             outside it, for every pair of radii that fits on the screen and
+             for ellipses clipped by each edge. Then (with "bench") compares
+             pixel and row coverage and timings with the trig-stepped fill it
+             replaced.
+*******************************************************************************/
+
+#include "host.h"
+
+#define ELLIPSE_COLOR                    GColorRed
+#define MAX_TESTED_H_RADIUS              (SCREEN_WIDTH / 2 + 8)
+#define MAX_TESTED_V_RADIUS              (SCREEN_HEIGHT / 2 + 8)
+#define NUM_CLIPPED_CENTERS              4
+#define NUM_BENCHMARK_ELLIPSES           4
+#define BENCHMARK_REPS                   100000
+
+// The trig-stepped fill's constants:
+#define NINETY_DEGREES                   (TRIG_MAX_ANGLE / 4)
+#define DEFAULT_ROTATION_RATE            (TRIG_MAX_ANGLE / 26)
+
+static const GPoint s_clipped_centers[NUM_CLIPPED_CENTERS] = {
+  {0, SCREEN_HEIGHT / 2},
+  {SCREEN_WIDTH - 1, SCREEN_HEIGHT / 2},
+  {SCREEN_WIDTH / 2, 0},
+  {SCREEN_WIDTH / 2, SCREEN_HEIGHT - 1},
+};
+
+// Exit, entrance and NPC shadow sizes, from the nearest visible depth to the
+// farthest (horizontal radius, vertical radius):
+static const uint8_t s_benchmark_radii[NUM_BENCHMARK_ELLIPSES][2] = {
+  {57, 18},
+  {33, 10},
+  {16, 6},
+  {4, 2},
+};
+
+/*******************************************************************************
+   Function: fill_ellipse_with_trig
+
+Description: The trig-stepped fill that "fill_ellipse" replaced: two lines per
+             DEFAULT_ROTATION_RATE step of a quarter turn.
+
+     Inputs: ctx      - Pointer to the relevant graphics context.
+             center   - Central coordinates of the ellipse.
+             h_radius - Horizontal radius.
+             v_radius - Vertical radius.
+             color    - Desired color.
+
+    Outputs: None.
+*******************************************************************************/
+static void fill_ellipse_with_trig(GContext *ctx,
+                                   const GPoint center,
+                                   const uint8_t h_radius,
+                                   const uint8_t v_radius,
+                                   const GColor color) {
+  int16_t theta;
+  uint8_t x_offset, y_offset;
+
+  graphics_context_set_stroke_color(ctx, color);
+  for (theta = 0; theta < NINETY_DEGREES; theta += DEFAULT_ROTATION_RATE) {
+    x_offset = cos_lookup(theta) * h_radius / TRIG_MAX_RATIO;
+    y_offset = sin_lookup(theta) * v_radius / TRIG_MAX_RATIO;
+    graphics_draw_line(ctx,
+                       GPoint(center.x - x_offset, center.y - y_offset),
+                       GPoint(center.x + x_offset, center.y - y_offset));
+    graphics_draw_line(ctx,
+                       GPoint(center.x - x_offset, center.y + y_offset),
+                       GPoint(center.x + x_offset, center.y + y_offset));
+  }
+}
+
+/*******************************************************************************
+   Function: is_in_ellipse
+
+Description: Determines whether a given pixel belongs to a given ellipse.
+
+     Inputs: x_offset - Horizontal distance from the center.
+             y_offset - Vertical distance from the center.
+             h_radius - Horizontal radius.
+             v_radius - Vertical radius.
+
+    Outputs: "True" if the pixel is inside (or on) the ellipse.
+*******************************************************************************/
+static bool is_in_ellipse(const int32_t x_offset,
+                          const int32_t y_offset,
+                          const int32_t h_radius,
+                          const int32_t v_radius) {
+  return abs(x_offset) <= h_radius &&  // For flat ellipses (v_radius == 0).
+         abs(y_offset) <= v_radius &&
+         x_offset * x_offset * v_radius * v_radius <=
+           h_radius * h_radius * (v_radius * v_radius - y_offset * y_offset);
+}
+
+/*******************************************************************************
+   Function: check_ellipse
+
+Description: Fills an ellipse into a cleared frame and compares every pixel of
+             the frame with "is_in_ellipse". Reports the first mismatch.
+
+     Inputs: center   - Central coordinates of the ellipse.
+             h_radius - Horizontal radius.
+             v_radius - Vertical radius.
+
+    Outputs: "True" if the frame matches.
+*******************************************************************************/
+static bool check_ellipse(const GPoint center,
+                          const uint8_t h_radius,
+                          const uint8_t v_radius) {
+  int16_t x, y;
+  bool is_filled;
+  const uint32_t draw_calls = g_host_counters.draw_calls;
+
+  host_clear_frame();
+  fill_ellipse(host_get_graphics_context(),
+               center,
+               h_radius,
+               v_radius,
+               ELLIPSE_COLOR);
+  if (g_host_counters.draw_calls != draw_calls + 1) {  // The capture.
+    printf("(%d, %d) %dx%d: used %lu draw calls, not one frame buffer "
+           "capture\n",
+           center.x,
+           center.y,
+           h_radius,
+           v_radius,
+           (unsigned long) (g_host_counters.draw_calls - draw_calls));
+    return false;
+  }
+  for (y = 0; y < SCREEN_HEIGHT; ++y) {
+    for (x = 0; x < SCREEN_WIDTH; ++x) {
+      is_filled = host_get_pixel(x, y) == ELLIPSE_COLOR.argb;
+      if (is_filled !=
+            is_in_ellipse(x - center.x, y - center.y, h_radius, v_radius)) {
+        printf("(%d, %d) %dx%d: pixel (%d, %d) is %s\n",
+               center.x,
+               center.y,
+               h_radius,
+               v_radius,
+               x,
+               y,
+               is_filled ? "filled" : "missing");
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+/*******************************************************************************
+   Function: test_ellipses
+
+Description: Checks every pair of radii up to MAX_TESTED_H_RADIUS and
+             MAX_TESTED_V_RADIUS, centered on the screen and clipped by each
+             of its edges. (Since the check compares whole rows with the
+             inequality, each touched row must hold exactly one span.)
+
+     Inputs: None.
+
+    Outputs: Number of ellipses that don't match.
+*******************************************************************************/
+static int test_ellipses(void) {
+  int16_t h_radius, v_radius, i;
+  int num_checked = 0, num_failures = 0;
+
+  for (h_radius = 0; h_radius <= MAX_TESTED_H_RADIUS; ++h_radius) {
+    for (v_radius = 0; v_radius <= MAX_TESTED_V_RADIUS; ++v_radius) {
+      num_failures += !check_ellipse(GPoint(SCREEN_WIDTH / 2,
+                                            SCREEN_HEIGHT / 2),
+                                     h_radius,
+                                     v_radius);
+      num_checked++;
+      if (h_radius % 8 == 0 && v_radius % 8 == 0) {
+        for (i = 0; i < NUM_CLIPPED_CENTERS; ++i) {
+          num_failures += !check_ellipse(s_clipped_centers[i],
+                                         h_radius,
+                                         v_radius);
+          num_checked++;
+        }
+      }
+    }
+  }
+  printf("ellipses: %d checked, %d mismatched\n", num_checked, num_failures);
+
+  return num_failures;
+}
+
+/*******************************************************************************
+   Function: measure_coverage
+
+Description: Counts the pixels and rows a given fill covers for one ellipse.
+
+     Inputs: fill       - "fill_ellipse" or "fill_ellipse_with_trig".
+             h_radius   - Horizontal radius.
+             v_radius   - Vertical radius.
+             num_pixels - Set to the number of filled pixels.
+             num_rows   - Set to the number of rows with any filled pixels.
+
+    Outputs: None.
+*******************************************************************************/
+static void measure_coverage(void (*fill)(GContext *,
+                                          const GPoint,
+                                          const uint8_t,
+                                          const uint8_t,
+                                          const GColor),
+                             const uint8_t h_radius,
+                             const uint8_t v_radius,
+                             int *const num_pixels,
+                             int *const num_rows) {
+  int16_t x, y, row_pixels;
+
+  *num_pixels = *num_rows = 0;
+  host_clear_frame();
+  fill(host_get_graphics_context(),
+       GPoint(SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2),
+       h_radius,
+       v_radius,
+       ELLIPSE_COLOR);
+  for (y = 0; y < SCREEN_HEIGHT; ++y) {
+    row_pixels = 0;
+    for (x = 0; x < SCREEN_WIDTH; ++x) {
+      row_pixels += host_get_pixel(x, y) == ELLIPSE_COLOR.argb;
+    }
+    *num_pixels += row_pixels;
+    *num_rows += row_pixels > 0;
+  }
+}
+
+/*******************************************************************************
+   Function: time_fill
+
+Description: Times a given fill for one ellipse.
+
+     Inputs: fill     - "fill_ellipse" or "fill_ellipse_with_trig".
+             h_radius - Horizontal radius.
+             v_radius - Vertical radius.
+
+    Outputs: Mean nanoseconds per ellipse.
+*******************************************************************************/
+static double time_fill(void (*fill)(GContext *,
+                                     const GPoint,
+                                     const uint8_t,
+                                     const uint8_t,
+                                     const GColor),
+                        const uint8_t h_radius,
+                        const uint8_t v_radius) {
+  int i;
+  struct timespec start_time, end_time;
+
+  clock_gettime(CLOCK_MONOTONIC, &start_time);
+  for (i = 0; i < BENCHMARK_REPS; ++i) {
+    fill(host_get_graphics_context(),
+         GPoint(SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2),
+         h_radius,
+         v_radius,
+         ELLIPSE_COLOR);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end_time);
+
+  return ((end_time.tv_sec - start_time.tv_sec) * 1e9 +
+          (end_time.tv_nsec - start_time.tv_nsec)) / BENCHMARK_REPS;
+}
+
+/*******************************************************************************
+   Function: benchmark
+
+Description: Prints pixel and row coverage, draw calls and timings for the
+             trig-stepped fill and "fill_ellipse" at the game's ellipse sizes.
+
+     Inputs: None.
+
+    Outputs: None.
+*******************************************************************************/
+static void benchmark(void) {
+  int8_t i;
+  int trig_pixels, trig_rows, scan_pixels, scan_rows;
+  uint32_t trig_draw_calls, scan_draw_calls;
+  uint8_t h_radius, v_radius;
+
+  printf("radii  pixels (trig/scan)  rows (trig/scan)  draw calls  "
+         "ns (trig/scan)\n");
+  for (i = 0; i < NUM_BENCHMARK_ELLIPSES; ++i) {
+    h_radius = s_benchmark_radii[i][0];
+    v_radius = s_benchmark_radii[i][1];
+    trig_draw_calls = g_host_counters.draw_calls;
+    measure_coverage(fill_ellipse_with_trig,
+                     h_radius,
+                     v_radius,
+                     &trig_pixels,
+                     &trig_rows);
+    trig_draw_calls = g_host_counters.draw_calls - trig_draw_calls;
+    scan_draw_calls = g_host_counters.draw_calls;
+    measure_coverage(fill_ellipse,
+                     h_radius,
+                     v_radius,
+                     &scan_pixels,
+                     &scan_rows);
+    scan_draw_calls = g_host_counters.draw_calls - scan_draw_calls;
+    printf("%2dx%-2d  %5d / %-5d         %2d / %-2d           %2lu / %-2lu    "
+           "%.0f / %.0f\n",
+           h_radius,
+           v_radius,
+           trig_pixels,
+           scan_pixels,
+           trig_rows,
+           scan_rows,
+           (unsigned long) trig_draw_calls,
+           (unsigned long) scan_draw_calls,
+           time_fill(fill_ellipse_with_trig, h_radius, v_radius),
+           time_fill(fill_ellipse, h_radius, v_radius));
+  }
+}
+
+/*******************************************************************************
+   Function: main
+
+Description: Runs the checks, then (with "bench") the comparison.
+
+     Inputs: argc - Number of command-line arguments.
+             argv - Command-line arguments.
+
+    Outputs: Zero if every check passes.
+*******************************************************************************/
+int main(int argc, char **argv) {
+  int num_failures;
+
+  init();
+  num_failures = test_ellipses();
+  if (argc > 1 && !strcmp(argv[1], "bench")) {
+    benchmark();
+  }
+  deinit();
+  printf("%s\n", num_failures ? "FAILED" : "passed");
+
+  return num_failures ? 1 : 0;
+}
@@ -0,0 +1,366 @@
+/*******************************************************************************
+   Filename: fixed_point_test.c
+
+Description: Checks the renderer's Q16.16 fixed-point geometry against the
+             floating-point code it replaced, then times both:
+
+               - Wall column tables ("init_wall_columns") must match the float
+                 version exactly, column for column.
+               - Ellipse radii (ELLIPSE_RADIUS_RATIO products) must match for
+                 every operand up to the screen's height.
+               - Status meters drawn by "draw_status_meter" may differ from the
+                 float version by at most one pixel.
+
+             The host has an FPU, so the timings understate the gap on the
+             watch, where each float operation is a soft-float library call.
+*******************************************************************************/
+
+#include "host.h"
+
+#define FLOAT_ELLIPSE_RADIUS_RATIO       0.4
+#define MAX_TESTED_METER_VALUE           400
+#define MAX_METER_DIFFERENCE             1
+#define BENCHMARK_REPS                   2000
+
+/*******************************************************************************
+   Function: init_wall_columns_with_floats
+
+Description: The float version of "init_wall_columns", writing into a given
+             column table instead of "g_wall_columns".
+
+     Inputs: quad        - Pointer to the wall quad whose columns are to be
+                           initialized.
+             upper_left  - Upper-left coordinates of the wall.
+             lower_left  - Lower-left coordinates of the wall.
+             upper_right - Upper-right coordinates of the wall.
+             columns     - The column table to be written.
+
+    Outputs: None.
+*******************************************************************************/
+static void init_wall_columns_with_floats(const wall_quad_t *const quad,
+                                          const GPoint upper_left,
+                                          const GPoint lower_left,
+                                          const GPoint upper_right,
+                                          wall_column_t *const columns) {
+  int16_t i, shading_offset, half_shading_offset, top, bottom, phase;
+  float dy_over_dx = (float) (upper_right.y - upper_left.y) /
+                             (upper_right.x - upper_left.x),
+        bottom_limit;
+  wall_column_t *column = columns + quad->first_column;
+
+  for (i = quad->x; i < quad->x + quad->num_columns; ++i, ++column) {
+    shading_offset = 1 + ((upper_left.y + (i - upper_left.x) * dy_over_dx) /
+                          MAX_VISIBILITY_DEPTH);
+    if ((int16_t) (upper_left.y + (i - upper_left.x) * dy_over_dx) %
+        MAX_VISIBILITY_DEPTH >= MAX_VISIBILITY_DEPTH / 2 +
+                                MAX_VISIBILITY_DEPTH % 2) {
+      shading_offset++;
+    }
+    half_shading_offset = (shading_offset / 2) + (shading_offset % 2);
+    if (shading_offset - 3 > NUM_BACKGROUND_COLORS_PER_SCHEME) {
+      column->color_index = NUM_BACKGROUND_COLORS_PER_SCHEME - 1;
+    } else if (shading_offset > 4) {
+      column->color_index = shading_offset - 4;
+    } else {
+      column->color_index = 0;
+    }
+    top = upper_left.y + (i - upper_left.x) * dy_over_dx;
+    bottom_limit = lower_left.y - (i - upper_left.x) * dy_over_dx;
+    bottom = bottom_limit;
+    if (bottom < bottom_limit) {
+      bottom++;
+    }
+    if (top < 0) {
+      top = 0;
+    }
+    if (bottom > SCREEN_HEIGHT) {
+      bottom = SCREEN_HEIGHT;
+    }
+    column->top = top;
+    column->bottom = bottom;
+    phase = ((int16_t) ((i - upper_left.x) * dy_over_dx) +
+             (i % 2 == 0 ? 0 : half_shading_offset) + top) % shading_offset;
+    if (phase < 0) {
+      phase += shading_offset;
+    }
+    column->first_dot = top + (phase == 0 ? 0 : shading_offset - phase);
+    column->dot_spacing = shading_offset;
+  }
+}
+
+/*******************************************************************************
+   Function: for_each_wall_quad
+
+Description: Calls a given function for every wall quad that has columns.
+
+     Inputs: init_columns - Function to call with each quad and its corners.
+             columns      - Column table passed through to "init_columns".
+
+    Outputs: Number of columns covered.
+*******************************************************************************/
+static int for_each_wall_quad(void (*init_columns)(const wall_quad_t *const,
+                                                   const GPoint,
+                                                   const GPoint,
+                                                   const GPoint,
+                                                   wall_column_t *const),
+                              wall_column_t *const columns) {
+  int8_t i, j, side;
+  int num_columns = 0;
+  wall_quad_t *quad;
+  GPoint upper_left, lower_left, upper_right;
+
+  for (i = 0; i < MAX_VISIBILITY_DEPTH - 1; ++i) {
+    for (j = 0; j < (STRAIGHT_AHEAD * 2) + 1; ++j) {
+      for (side = 0; side < NUM_WALL_SIDES; ++side) {
+        quad = &g_wall_quads[i][j][side];
+        if (quad->num_columns > 0) {
+          get_wall_corners(i, j, side, &upper_left, &lower_left, &upper_right);
+          init_columns(quad, upper_left, lower_left, upper_right, columns);
+          num_columns += quad->num_columns;
+        }
+      }
+    }
+  }
+
+  return num_columns;
+}
+
+/*******************************************************************************
+   Function: init_wall_columns_with_fixed_point
+
+Description: Adapts the game's "init_wall_columns" for "for_each_wall_quad".
+
+     Inputs: quad        - Pointer to the wall quad whose columns are to be
+                           initialized.
+             upper_left  - Upper-left coordinates of the wall.
+             lower_left  - Lower-left coordinates of the wall.
+             upper_right - Upper-right coordinates of the wall.
+             columns     - Ignored ("g_wall_columns" is always written).
+
+    Outputs: None.
+*******************************************************************************/
+static void init_wall_columns_with_fixed_point(const wall_quad_t *const quad,
+                                               const GPoint upper_left,
+                                               const GPoint lower_left,
+                                               const GPoint upper_right,
+                                               wall_column_t *const columns) {
+  init_wall_columns(quad, upper_left, lower_left, upper_right);
+}
+
+/*******************************************************************************
+   Function: test_wall_columns
+
+Description: Compares the game's wall column table with the float version's.
+
+     Inputs: None.
+
+    Outputs: Number of mismatched columns.
+*******************************************************************************/
+static int test_wall_columns(void) {
+  int i, num_columns, num_mismatches = 0;
+  wall_column_t *columns;
+
+  num_columns = for_each_wall_quad(init_wall_columns_with_fixed_point, NULL);
+  columns = calloc(num_columns, sizeof(wall_column_t));
+  for_each_wall_quad(init_wall_columns_with_floats, columns);
+  for (i = 0; i < num_columns; ++i) {
+    if (memcmp(&columns[i], &g_wall_columns[i], sizeof(wall_column_t))) {
+      num_mismatches++;
+    }
+  }
+  printf("wall columns: %d compared, %d mismatched\n",
+         num_columns,
+         num_mismatches);
+  free(columns);
+
+  return num_mismatches;
+}
+
+/*******************************************************************************
+   Function: test_ellipse_radii
+
+Description: Compares fixed-point ellipse radii with the float version's for
+             every operand up to the screen's height (wall widths and heights
+             never exceed it).
+
+     Inputs: None.
+
+    Outputs: Number of mismatched radii.
+*******************************************************************************/
+static int test_ellipse_radii(void) {
+  int16_t n;
+  int num_mismatches = 0;
+
+  for (n = 0; n <= SCREEN_HEIGHT; ++n) {
+    if ((uint8_t) FIXED_TO_INT(ELLIPSE_RADIUS_RATIO * n) !=
+        (uint8_t) (FLOAT_ELLIPSE_RADIUS_RATIO * n)) {
+      num_mismatches++;
+    }
+  }
+  printf("ellipse radii: %d compared, %d mismatched\n",
+         SCREEN_HEIGHT + 1,
+         num_mismatches);
+
+  return num_mismatches;
+}
+
+/*******************************************************************************
+   Function: get_meter_fill_width
+
+Description: Draws a health meter for a given ratio and measures how much of
+             it is filled, along its middle row.
+
+     Inputs: ratio - Fixed-point ratio passed to "draw_status_meter".
+
+    Outputs: Width of the filled (red) part, in pixels.
+*******************************************************************************/
+static int16_t get_meter_fill_width(const fixed_t ratio) {
+  const GPoint origin = GPoint(STATUS_METER_PADDING, STATUS_METER_PADDING);
+  int16_t x;
+
+  host_clear_frame();
+  draw_status_meter(host_get_graphics_context(), origin, ratio);
+  for (x = 0; x < STATUS_METER_WIDTH; ++x) {
+    if (host_get_pixel(origin.x + x, origin.y + STATUS_METER_HEIGHT / 2) !=
+          GColorRed.argb) {
+      break;
+    }
+  }
+
+  return x;
+}
+
+/*******************************************************************************
+   Function: test_status_meters
+
+Description: Compares status meters drawn from fixed-point ratios with the
+             widths the float version drew, for every current value of every
+             maximum up to MAX_TESTED_METER_VALUE.
+
+     Inputs: None.
+
+    Outputs: Number of meters that differ by more than MAX_METER_DIFFERENCE.
+*******************************************************************************/
+static int test_status_meters(void) {
+  int16_t max, current, difference, largest_difference = 0;
+  int num_compared = 0, num_differing = 0;
+
+  for (max = 1; max <= MAX_TESTED_METER_VALUE; ++max) {
+    for (current = 0; current <= max; ++current) {
+      difference = get_meter_fill_width(INT_TO_FIXED(current) / max) -
+                   (uint8_t) ((float) current / max * STATUS_METER_WIDTH);
+      difference = abs(difference);
+      num_compared++;
+      if (difference > 0) {
+        num_differing++;
+      }
+      if (difference > largest_difference) {
+        largest_difference = difference;
+      }
+    }
+  }
+  printf("status meters: %d compared, %d differing (by up to %d pixel%s)\n",
+         num_compared,
+         num_differing,
+         largest_difference,
+         largest_difference == 1 ? "" : "s");
+
+  return largest_difference > MAX_METER_DIFFERENCE;
+}
+
+/*******************************************************************************
+   Function: get_time_in_ns
+
+Description: Reads the host's monotonic clock.
+
+     Inputs: None.
+
+    Outputs: Nanoseconds since an arbitrary starting point.
+*******************************************************************************/
+static uint64_t get_time_in_ns(void) {
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (uint64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+/*******************************************************************************
+   Function: benchmark
+
+Description: Times building every wall column table and computing meter widths
+             and ellipse radii, with floats and with fixed point.
+
+     Inputs: None.
+
+    Outputs: None.
+*******************************************************************************/
+static void benchmark(void) {
+  int i, num_columns = for_each_wall_quad(init_wall_columns_with_fixed_point,
+                                          NULL);
+  int16_t n;
+  volatile int32_t sink = 0;
+  uint64_t start_time, float_time, fixed_time;
+  wall_column_t *columns = calloc(num_columns, sizeof(wall_column_t));
+
+  start_time = get_time_in_ns();
+  for (i = 0; i < BENCHMARK_REPS; ++i) {
+    for_each_wall_quad(init_wall_columns_with_floats, columns);
+  }
+  float_time = get_time_in_ns() - start_time;
+  start_time = get_time_in_ns();
+  for (i = 0; i < BENCHMARK_REPS; ++i) {
+    for_each_wall_quad(init_wall_columns_with_fixed_point, NULL);
+  }
+  fixed_time = get_time_in_ns() - start_time;
+  printf("wall columns: float %.1f ns/column, fixed %.1f ns/column\n",
+         (double) float_time / BENCHMARK_REPS / num_columns,
+         (double) fixed_time / BENCHMARK_REPS / num_columns);
+  free(columns);
+
+  start_time = get_time_in_ns();
+  for (i = 0; i < BENCHMARK_REPS; ++i) {
+    for (n = 1; n <= SCREEN_HEIGHT; ++n) {
+      sink += (uint8_t) ((float) (n / 2) / n * STATUS_METER_WIDTH);
+      sink += (uint8_t) (FLOAT_ELLIPSE_RADIUS_RATIO * n);
+    }
+  }
+  float_time = get_time_in_ns() - start_time;
+  start_time = get_time_in_ns();
+  for (i = 0; i < BENCHMARK_REPS; ++i) {
+    for (n = 1; n <= SCREEN_HEIGHT; ++n) {
+      sink += (uint8_t) FIXED_TO_INT(INT_TO_FIXED(n / 2) / n *
+                                     STATUS_METER_WIDTH);
+      sink += (uint8_t) FIXED_TO_INT(ELLIPSE_RADIUS_RATIO * n);
+    }
+  }
+  fixed_time = get_time_in_ns() - start_time;
+  printf("meter width + ellipse radius: float %.1f ns, fixed %.1f ns\n",
+         (double) float_time / BENCHMARK_REPS / SCREEN_HEIGHT,
+         (double) fixed_time / BENCHMARK_REPS / SCREEN_HEIGHT);
+}
+
+/*******************************************************************************
+   Function: main
+
+Description: Runs the comparisons, then (with "bench") the timings.
+
+     Inputs: argc - Number of command-line arguments.
+             argv - Command-line arguments.
+
+    Outputs: Zero if every comparison passes.
+*******************************************************************************/
+int main(int argc, char **argv) {
+  int num_failures;
+
+  init();
+  num_failures = test_wall_columns() + test_ellipse_radii() +
+                 test_status_meters();
+  if (argc > 1 && !strcmp(argv[1], "bench")) {
+    benchmark();
+  }
+  deinit();
+  printf("%s\n", num_failures ? "FAILED" : "passed");
+
+  return num_failures ? 1 : 0;
+}
@@ -0,0 +1,420 @@
+/*******************************************************************************
+   Filename: generator_test.c
+
+Description: Generates many levels with "generate_location", in every depth
+             band, into the spare location struct (as prefetching does), and
+             checks the generator's guarantees for each one:
+
+               - The entrance and the exit lie on opposite edges of the map.
+               - An open path leads from the entrance to the exit.
+               - The only NPC is a mage, on an open cell beside the exit.
+               - Loot turns up at roughly 1 in LOOT_CHANCE open cells (over
+                 each band as a whole), and never fills the side table of
+                 exits and loot.
+               - At MAX_DEPTH, no exit is left at all.
+               - The current location, the player's position and the caches
+                 derived from the map are left alone.
+
+             Prints mean, p99 and worst-case generation times per band. Each
+             level is generated from its own seed, NUM_TIMINGS times over, and
+             only its best time counts, so the host's scheduling noise doesn't
+             pass for a slow level.
+
+               generator_test [levels per band] [seed]
+*******************************************************************************/
+
+#include "host.h"
+
+#define DEFAULT_LEVELS_PER_BAND          20000
+#define MAX_REPORTED_FAILURES            10
+#define NUM_TIMINGS                      2  // Per level (the best is kept).
+
+// The current location and everything derived from it, as they were before
+// generating levels into "g_next_location":
+static location_t s_location;
+static GPoint s_player_position;
+static int8_t s_npc_grid[MAP_WIDTH][MAP_HEIGHT],
+              s_horizontal_runs[MAP_WIDTH][MAP_HEIGHT],
+              s_vertical_runs[MAP_WIDTH][MAP_HEIGHT];
+static int16_t s_distance_field[MAP_WIDTH][MAP_HEIGHT];
+static uint32_t s_solid_cells[SOLID_CELLS_NUM_WORDS],
+                s_solid_cell_columns[SOLID_CELLS_NUM_WORDS];
+
+/*******************************************************************************
+   Function: get_time_in_ns
+
+Description: Reads the host's monotonic clock.
+
+     Inputs: None.
+
+    Outputs: Nanoseconds since an arbitrary starting point.
+*******************************************************************************/
+static uint64_t get_time_in_ns(void) {
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (uint64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+/*******************************************************************************
+   Function: compare_times
+
+Description: Comparison function for sorting generation times with "qsort".
+
+     Inputs: a - Pointer to a generation time.
+             b - Pointer to another generation time.
+
+    Outputs: Negative, zero or positive as "a" is less than, equal to or
+             greater than "b".
+*******************************************************************************/
+static int compare_times(const void *a, const void *b) {
+  uint64_t time_a = *(const uint64_t *) a,
+           time_b = *(const uint64_t *) b;
+
+  return time_a < time_b ? -1 : time_a > time_b;
+}
+
+/*******************************************************************************
+   Function: is_on_edge
+
+Description: Determines whether a given cell lies on a given edge of the map.
+
+     Inputs: cell      - Coordinates of the cell of interest.
+             direction - The edge's direction.
+
+    Outputs: "True" if it does.
+*******************************************************************************/
+static bool is_on_edge(const GPoint cell, const int8_t direction) {
+  return direction == NORTH ? cell.y == 0              :
+         direction == SOUTH ? cell.y == MAP_HEIGHT - 1 :
+         direction == EAST  ? cell.x == MAP_WIDTH - 1  :
+                              cell.x == 0;
+}
+
+/*******************************************************************************
+   Function: is_reachable
+
+Description: Determines, by breadth-first search over a location's non-solid
+             cells, whether one cell can be reached from another.
+
+     Inputs: location - Pointer to the location of interest.
+             from     - Coordinates of the starting cell.
+             to       - Coordinates of the destination.
+
+    Outputs: "True" if an open path connects them.
+*******************************************************************************/
+static bool is_reachable(const location_t *const location,
+                         const GPoint from,
+                         const GPoint to) {
+  static bool visited[MAP_WIDTH][MAP_HEIGHT];
+  static GPoint queue[MAP_WIDTH * MAP_HEIGHT];
+  int head = 0, tail = 0;
+  int8_t i;
+  GPoint cell, neighbor;
+
+  memset(visited, 0, sizeof(visited));
+  queue[tail++] = from;
+  visited[from.x][from.y] = true;
+  while (head < tail) {
+    cell = queue[head++];
+    if (gpoint_equal(&cell, &to)) {
+      return true;
+    }
+    for (i = 0; i < NUM_DIRECTIONS; ++i) {
+      neighbor = GPoint(cell.x + g_direction_vectors[i].x,
+                        cell.y + g_direction_vectors[i].y);
+      if (neighbor.x >= 0 && neighbor.x < MAP_WIDTH &&
+          neighbor.y >= 0 && neighbor.y < MAP_HEIGHT &&
+          !visited[neighbor.x][neighbor.y] &&
+          get_location_cell_type(location, neighbor) != SOLID) {
+        visited[neighbor.x][neighbor.y] = true;
+        queue[tail++] = neighbor;
+      }
+    }
+  }
+
+  return false;
+}
+
+/*******************************************************************************
+   Function: check_level
+
+Description: Checks a level just generated.
+
+     Inputs: location   - Pointer to the level.
+             direction  - Direction "generate_location" returned.
+             entrance   - Entrance "generate_location" returned.
+             has_exit   - "False" if the level is at MAX_DEPTH.
+             num_open   - Incremented by the number of non-solid cells.
+             num_loot   - Incremented by the number of cells holding loot.
+
+    Outputs: A description of the first problem found, or NULL if none.
+*******************************************************************************/
+static const char *check_level(const location_t *const location,
+                               const int8_t direction,
+                               const GPoint entrance,
+                               const bool has_exit,
+                               long *const num_open,
+                               long *const num_loot) {
+  int8_t x, y, type, num_exits = 0;
+  GPoint cell, exit_position = GPoint(NONE, NONE);
+  const npc_t *mage;
+
+  for (x = 0; x < MAP_WIDTH; ++x) {
+    for (y = 0; y < MAP_HEIGHT; ++y) {
+      cell = GPoint(x, y);
+      type = get_location_cell_type(location, cell);
+      if (type == EXIT) {
+        exit_position = cell;
+        num_exits++;
+      }
+      if (type != SOLID) {
+        (*num_open)++;
+      }
+      if (type > EXIT) {
+        (*num_loot)++;
+      }
+    }
+  }
+  if (!gpoint_equal(&entrance, &location->entrance)) {
+    return "the entrance returned isn't the location's";
+  }
+  if (!is_on_edge(entrance, g_opposite_directions[direction]) ||
+      get_location_cell_type(location, entrance) == SOLID) {
+    return "entrance isn't open on the edge opposite the exit's";
+  }
+  if (location->num_active_npcs != 1) {
+    return "there isn't exactly one NPC";
+  }
+  mage = &location->npcs[location->active_npcs[0]];
+  if (mage->type != MAGE ||
+      get_location_cell_type(location, mage->position) == SOLID) {
+    return "the NPC isn't a mage on an open cell";
+  }
+  if (!has_exit) {
+    return num_exits == 0 ? NULL : "an exit was left at MAX_DEPTH";
+  }
+  if (num_exits != 1) {
+    return "there isn't exactly one exit";
+  }
+  if (!is_on_edge(exit_position, direction)) {
+    return "exit isn't on the edge the returned direction points to";
+  }
+  if (MANHATTAN_DISTANCE(mage->position, exit_position) != 1) {
+    return "mage isn't beside the exit";
+  }
+  if (!is_reachable(location, entrance, exit_position)) {
+    return "exit can't be reached from the entrance";
+  }
+
+  return NULL;
+}
+
+/*******************************************************************************
+   Function: time_level
+
+Description: Generates a level from a given seed NUM_TIMINGS times, timing
+             each generation.
+
+     Inputs: depth    - The player's depth (the level is generated for the one
+                        below it).
+             seed     - Seed for "srand".
+             entrance - Set to the entrance "generate_location" returned.
+             time     - Set to the best generation time, in nanoseconds.
+
+    Outputs: The direction "generate_location" returned.
+*******************************************************************************/
+static int8_t time_level(const int8_t depth,
+                         const unsigned int seed,
+                         GPoint *const entrance,
+                         uint64_t *const time) {
+  int8_t i, direction;
+  uint64_t start_time;
+
+  *time = UINT64_MAX;
+  for (i = 0; i < NUM_TIMINGS; ++i) {
+    g_player->int8_stats[DEPTH] = depth;
+    srand(seed);
+    start_time = get_time_in_ns();
+    direction = generate_location(g_next_location, entrance);
+    start_time = get_time_in_ns() - start_time;
+    if (start_time < *time) {
+      *time = start_time;
+    }
+  }
+
+  return direction;
+}
+
+/*******************************************************************************
+   Function: save_current_location
+
+Description: Copies the current location, the player's position and the caches
+             derived from the map, for "current_location_is_intact".
+
+     Inputs: None.
+
+    Outputs: None.
+*******************************************************************************/
+static void save_current_location(void) {
+  s_location = *g_location;
+  s_player_position = g_player->position;
+  memcpy(s_npc_grid, g_npc_grid, sizeof(s_npc_grid));
+  memcpy(s_horizontal_runs, g_horizontal_runs, sizeof(s_horizontal_runs));
+  memcpy(s_vertical_runs, g_vertical_runs, sizeof(s_vertical_runs));
+  memcpy(s_distance_field, g_distance_field, sizeof(s_distance_field));
+  memcpy(s_solid_cells, g_solid_cells, sizeof(s_solid_cells));
+  memcpy(s_solid_cell_columns,
+         g_solid_cell_columns,
+         sizeof(s_solid_cell_columns));
+}
+
+/*******************************************************************************
+   Function: current_location_is_intact
+
+Description: Compares the current location, the player's position and the
+             caches derived from the map with the copies made by
+             "save_current_location".
+
+     Inputs: None.
+
+    Outputs: "True" if nothing has changed.
+*******************************************************************************/
+static bool current_location_is_intact(void) {
+  return !memcmp(&s_location, g_location, sizeof(location_t)) &&
+         gpoint_equal(&s_player_position, &g_player->position) &&
+         !memcmp(s_npc_grid, g_npc_grid, sizeof(s_npc_grid)) &&
+         !memcmp(s_horizontal_runs,
+                 g_horizontal_runs,
+                 sizeof(s_horizontal_runs)) &&
+         !memcmp(s_vertical_runs, g_vertical_runs, sizeof(s_vertical_runs)) &&
+         !memcmp(s_distance_field,
+                 g_distance_field,
+                 sizeof(s_distance_field)) &&
+         !memcmp(s_solid_cells, g_solid_cells, sizeof(s_solid_cells)) &&
+         !memcmp(s_solid_cell_columns,
+                 g_solid_cell_columns,
+                 sizeof(s_solid_cell_columns));
+}
+
+/*******************************************************************************
+   Function: test_band
+
+Description: Generates and checks a given number of levels at a given depth,
+             then prints the band's timings and loot density.
+
+     Inputs: depth      - The player's depth (levels are generated for the one
+                          below it).
+             num_levels - Number of levels to generate.
+             first_seed - Seed for the first level (the rest follow on).
+             times      - Space for "num_levels" generation times.
+
+    Outputs: Number of levels that failed a check (plus one if the band's loot
+             density is far off 1 in LOOT_CHANCE, one if any level came within
+             an entry of filling the side table, and one if the current
+             location or its caches changed).
+*******************************************************************************/
+static long test_band(const int8_t depth,
+                      const long num_levels,
+                      const unsigned int first_seed,
+                      uint64_t *const times) {
+  long i, num_failures = 0, num_open = 0, num_loot = 0;
+  int8_t direction;
+  int16_t most_special_cells = 0;
+  GPoint entrance;
+  uint64_t total_time = 0;
+  double loot_density;
+  const char *problem;
+
+  for (i = 0; i < num_levels; ++i) {
+    direction = time_level(depth, first_seed + i, &entrance, &times[i]);
+    total_time += times[i];
+    if (g_next_location->num_special_cells > most_special_cells) {
+      most_special_cells = g_next_location->num_special_cells;
+    }
+    problem = check_level(g_next_location,
+                          direction,
+                          entrance,
+                          depth + 1 < MAX_DEPTH,
+                          &num_open,
+                          &num_loot);
+    if (problem != NULL && num_failures++ < MAX_REPORTED_FAILURES) {
+      printf("depth %d, seed %ld: %s\n",
+             depth + 1,
+             first_seed + i,
+             problem);
+    }
+  }
+  qsort(times, num_levels, sizeof(uint64_t), compare_times);
+  loot_density = (double) num_loot / num_open;
+  printf("depth %3d: %ld levels, mean %.2f us, p99 %.2f us, max %.2f us, "
+         "%.1f open cells/level, loot/open %.4f, special cells up to %d/%d, "
+         "%ld failed\n",
+         depth + 1,
+         num_levels,
+         total_time / 1e3 / num_levels,
+         times[num_levels * 99 / 100] / 1e3,
+         times[num_levels - 1] / 1e3,
+         (double) num_open / num_levels,
+         loot_density,
+         most_special_cells,
+         MAX_SPECIAL_CELLS,
+         num_failures);
+  if (depth + 1 < MAX_DEPTH &&
+      (loot_density < 0.5 / LOOT_CHANCE || loot_density > 2.0 / LOOT_CHANCE)) {
+    printf("depth %d: loot density is far off 1/%d\n",
+           depth + 1,
+           LOOT_CHANCE);
+    num_failures++;
+  }
+  if (most_special_cells >= MAX_SPECIAL_CELLS - 1) {
+    printf("depth %d: the side table of exits and loot (nearly) filled up\n",
+           depth + 1);
+    num_failures++;
+  }
+  if (!current_location_is_intact()) {
+    printf("depth %d: the current location or its caches changed\n",
+           depth + 1);
+    num_failures++;
+  }
+
+  return num_failures;
+}
+
+/*******************************************************************************
+   Function: main
+
+Description: Tests each depth band at its first depth, then the last depth.
+
+     Inputs: argc - Number of command-line arguments.
+             argv - Command-line arguments (see the file description).
+
+    Outputs: Zero if every level passes.
+*******************************************************************************/
+int main(int argc, char **argv) {
+  int8_t i;
+  long num_failures = 0;
+  const long num_levels = argc > 1 ? atol(argv[1]) :
+                                     DEFAULT_LEVELS_PER_BAND;
+  const unsigned int seed = argc > 2 ? atoi(argv[2]) : 1;
+  uint64_t *times = malloc(num_levels * sizeof(uint64_t));
+
+  init();
+  init_location();  // A current location for generation to leave alone.
+  update_distance_field();
+  save_current_location();
+  for (i = 0; i <= NUM_LEVEL_BANDS; ++i) {
+    num_failures += test_band(i < NUM_LEVEL_BANDS ?
+                                g_level_bands[i].min_depth - 1 :
+                                MAX_DEPTH - 1,
+                              num_levels,
+                              seed + i * num_levels,
+                              times);
+  }
+  free(times);
+  deinit();
+  printf("%s\n", num_failures ? "FAILED" : "passed");
+
+  return num_failures ? 1 : 0;
+}
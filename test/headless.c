@@ -0,0 +1,362 @@
+/*******************************************************************************
+   Filename: headless.c
+
+Description: Runs PebbleQuest headless against the host SDK stand-in:
+
+               headless golden            Prints a hash of every frame of a
+                                          walk through the test maps.
+               headless frames <dir>      Writes those frames as PPM files.
+               headless bench [reps]      Times "draw_scene" over the walk.
+               headless play <secs> [seed]
+                                          Plays a new game with random button
+                                          presses, one per tick, printing the
+                                          player's state and a frame hash.
+
+             The walk places the player on every open cell of each test map,
+             facing each direction, at both phases of the one-second
+             animations, and redraws the graphics window from scratch.
+*******************************************************************************/
+
+#include "host.h"
+
+#define NUM_TEST_MAPS                    3
+#define TEST_MAP_SIZE                    10
+#define NUM_ANIMATION_PHASES             2
+#define DEFAULT_BENCHMARK_REPS           5
+#define MAX_WALK_FRAMES                  (NUM_TEST_MAPS * MAP_WIDTH *         \
+                                          MAP_HEIGHT * NUM_DIRECTIONS *       \
+                                          NUM_ANIMATION_PHASES)
+#define NUM_PLAY_INPUTS                  5
+
+// "make golden-check" builds this runner against older revisions too, some of
+// which predate the scene cache, the NPC pool or "clear_map": the flag is then
+// a dummy, and the functions (declared weak) are skipped.
+bool g_scene_is_cached;
+void init_npc_pool(void);
+void clear_map(void);
+#pragma weak init_npc_pool
+#pragma weak clear_map
+
+// '#' = SOLID, '.' = EMPTY, 'X' = EXIT, 'L' = loot, 'N' = NPC (tiled, if the
+// map is larger):
+static const char *const s_test_maps[NUM_TEST_MAPS] = {
+  "##########"
+  "#........#"
+  "#.######.#"
+  "#.#L...#.#"
+  "#.#.##.#.#"
+  "#.#.##...#"
+  "#.#.######"
+  "#...#....#"
+  "###...##.X"
+  "##########",
+  ".........."
+  ".........."
+  "...#......"
+  ".........."
+  "......#..."
+  "....X....."
+  "..#......."
+  ".........."
+  ".L...#...."
+  "..........",
+  "..#.#.#.#."
+  "N..N..N..N"
+  "#.#.#.#.#."
+  "N..N..N..N"
+  "#.#L#.#.#."
+  "N..N..N..N"
+  "#.#.#.#.#."
+  "N..N..N..N"
+  "#.#.#.#.#X"
+  "N..N..N..N",
+};
+
+static const ButtonId s_play_inputs[NUM_PLAY_INPUTS] = {
+  BUTTON_ID_UP,
+  BUTTON_ID_UP,
+  BUTTON_ID_DOWN,
+  BUTTON_ID_SELECT,
+  BUTTON_ID_BACK,  // Stands for "no input".
+};
+
+/*******************************************************************************
+   Function: get_time_in_ns
+
+Description: Reads the host's monotonic clock.
+
+     Inputs: None.
+
+    Outputs: Nanoseconds since an arbitrary starting point.
+*******************************************************************************/
+static uint64_t get_time_in_ns(void) {
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (uint64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+/*******************************************************************************
+   Function: compare_times
+
+Description: Comparison function for sorting frame times with "qsort".
+
+     Inputs: a - Pointer to a frame time.
+             b - Pointer to another frame time.
+
+    Outputs: Negative, zero or positive as "a" is less than, equal to or
+             greater than "b".
+*******************************************************************************/
+static int compare_times(const void *a, const void *b) {
+  uint64_t time_a = *(const uint64_t *) a,
+           time_b = *(const uint64_t *) b;
+
+  return time_a < time_b ? -1 : time_a > time_b;
+}
+
+/*******************************************************************************
+   Function: load_test_map
+
+Description: Replaces the current location with a given test map.
+
+     Inputs: map - Index value for "s_test_maps".
+
+    Outputs: None.
+*******************************************************************************/
+static void load_test_map(const int8_t map) {
+  int8_t i, j, npc_type = 0;
+  char c;
+  GPoint cell;
+
+  g_location->floor_color_scheme = g_location->wall_color_scheme = 0;
+  g_location->entrance = GPoint(NONE, NONE);
+  for (i = 0; i < MAX_NPCS_AT_ONE_TIME; ++i) {
+    g_location->npcs[i].type = NONE;
+  }
+  if (init_npc_pool) {
+    init_npc_pool();
+  }
+  if (clear_map) {
+    clear_map();
+  }
+  g_player->position = GPoint(NONE, NONE);  // So it can't block NPCs.
+  for (i = 0; i < MAP_WIDTH; ++i) {
+    for (j = 0; j < MAP_HEIGHT; ++j) {
+      cell = GPoint(i, j);
+      c = s_test_maps[map][(j % TEST_MAP_SIZE) * TEST_MAP_SIZE +
+                           i % TEST_MAP_SIZE];
+      set_cell_type(cell, c == '#' ? SOLID  :
+                          c == 'X' ? EXIT   :
+                          c == 'L' ? SHIELD :
+                                     EMPTY);
+      if (c == 'N' && add_new_npc(npc_type, cell)) {
+        npc_type = (npc_type + 1) % NUM_NPC_TYPES;
+      }
+    }
+  }
+}
+
+/*******************************************************************************
+   Function: walk_test_maps
+
+Description: Redraws the graphics window for every pose of the walk through
+             the test maps, then either prints each frame's hash, writes each
+             frame to a file, or times each redraw.
+
+     Inputs: mode      - "golden", "frames" or "bench".
+             directory - Where frames are written (for "frames" only).
+             reps      - Redraws per pose (the fastest is kept, for "bench").
+
+    Outputs: Zero if successful.
+*******************************************************************************/
+static int walk_test_maps(const char *mode,
+                          const char *directory,
+                          const int reps) {
+  int8_t map, direction, phase;
+  int i, rep, num_frames = 0;
+  uint32_t draw_calls = 0;
+  uint64_t total_time = 0, start_time, frame_time,
+           *frame_times = malloc(MAX_WALK_FRAMES * sizeof(uint64_t));
+  char path[FILENAME_MAX];
+  GPoint cell;
+
+  for (map = 0; map < NUM_TEST_MAPS; ++map) {
+    load_test_map(map);
+    for (i = 0; i < MAP_WIDTH * MAP_HEIGHT * NUM_DIRECTIONS; ++i) {
+      cell = GPoint(i / NUM_DIRECTIONS % MAP_WIDTH,
+                    i / NUM_DIRECTIONS / MAP_WIDTH);
+      direction = i % NUM_DIRECTIONS;
+      if (get_cell_type(cell) < EMPTY || get_npc_at(cell) != NULL) {
+        continue;
+      }
+      g_player->position = cell;
+      set_player_direction(direction);
+      for (phase = 0; phase < NUM_ANIMATION_PHASES; ++phase) {
+        host_advance_time(1000);  // Flips the animations' phase.
+        frame_time = UINT64_MAX;
+        draw_calls -= g_host_counters.draw_calls;
+        for (rep = 0; rep < reps; ++rep) {
+          g_scene_is_cached = false;
+          start_time = get_time_in_ns();
+          host_render_window(g_windows[GRAPHICS_WINDOW]);
+          start_time = get_time_in_ns() - start_time;
+          if (start_time < frame_time) {
+            frame_time = start_time;
+          }
+        }
+        draw_calls += g_host_counters.draw_calls;
+        frame_times[num_frames++] = frame_time;
+        total_time += frame_time;
+        if (!strcmp(mode, "golden")) {
+          printf("%d %d %d %d %d %08lx\n",
+                 map,
+                 cell.x,
+                 cell.y,
+                 direction,
+                 phase,
+                 (unsigned long) host_frame_hash());
+        } else if (!strcmp(mode, "frames") && phase == 0) {
+          snprintf(path,
+                   sizeof(path),
+                   "%s/%d_%d_%d_%d.ppm",
+                   directory,
+                   map,
+                   cell.x,
+                   cell.y,
+                   direction);
+          if (!host_write_ppm(path)) {
+            fprintf(stderr, "Couldn't write %s.\n", path);
+            return 1;
+          }
+        }
+      }
+    }
+  }
+  if (!strcmp(mode, "bench")) {
+    qsort(frame_times, num_frames, sizeof(uint64_t), compare_times);
+    printf("frames: %d, draw calls/frame: %.1f, "
+           "mean %.1f us, p50 %.1f us, p95 %.1f us, p99 %.1f us, "
+           "max %.1f us\n",
+           num_frames,
+           (double) draw_calls / reps / num_frames,
+           total_time / 1e3 / num_frames,
+           frame_times[num_frames / 2] / 1e3,
+           frame_times[num_frames * 95 / 100] / 1e3,
+           frame_times[num_frames * 99 / 100] / 1e3,
+           frame_times[num_frames - 1] / 1e3);
+  }
+  free(frame_times);
+
+  return 0;
+}
+
+/*******************************************************************************
+   Function: return_to_graphics_window
+
+Description: Dismisses whatever the game has shown over the graphics window:
+             narrations are read, loot is taken, a level-up goes to the first
+             attribute, and any other menu is backed out of.
+
+     Inputs: None.
+
+    Outputs: "False" if the main menu is showing (i.e., the player has died).
+*******************************************************************************/
+static bool return_to_graphics_window(void) {
+  Window *window;
+
+  while ((window = window_stack_get_top_window()) !=
+           g_windows[GRAPHICS_WINDOW]) {
+    if (window == g_windows[MAIN_MENU] || window == NULL) {
+      return false;
+    }
+    host_click(window == g_windows[NARRATION_WINDOW] ||
+               window == g_windows[LOOT_MENU] ||
+               window == g_windows[LEVEL_UP_MENU] ? BUTTON_ID_SELECT :
+                                                     BUTTON_ID_BACK);
+  }
+
+  return true;
+}
+
+/*******************************************************************************
+   Function: play
+
+Description: Starts a new game from the main menu and plays it for a given
+             number of seconds: each second, one random button press (or none)
+             is followed by a tick, then the top window is redrawn and the
+             player's depth, position, direction and health are printed with
+             a hash of the frame. Anything shown over the graphics window is
+             dismissed first. The session ends early if the player dies.
+
+     Inputs: seconds - Number of ticks to play for.
+
+    Outputs: Zero if successful.
+*******************************************************************************/
+static int play(const int seconds) {
+  int second;
+  ButtonId input;
+
+  host_click(BUTTON_ID_SELECT);  // "Play" (the main menu's first row).
+  for (second = 0; second < seconds; ++second) {
+    if (!return_to_graphics_window()) {
+      printf("%d: the player has died\n", second);
+      break;
+    }
+    input = s_play_inputs[rand() % NUM_PLAY_INPUTS];
+    if (input != BUTTON_ID_BACK) {
+      host_click(input);
+    }
+    host_tick();
+    host_render_top_window();
+    printf("%d: depth %d (%d, %d) %d health %d %08lx\n",
+           second,
+           g_player->int8_stats[DEPTH],
+           g_player->position.x,
+           g_player->position.y,
+           g_player->direction,
+           g_player->int16_stats[CURRENT_HEALTH],
+           (unsigned long) host_frame_hash());
+  }
+
+  return 0;
+}
+
+/*******************************************************************************
+   Function: main
+
+Description: Sets the game up as it would on the watch (with no saved data),
+             then runs the requested mode.
+
+     Inputs: argc - Number of command-line arguments.
+             argv - Command-line arguments (see the file description).
+
+    Outputs: Zero if successful.
+*******************************************************************************/
+int main(int argc, char **argv) {
+  const char *mode = argc > 1 ? argv[1] : "golden";
+  int status;
+
+  init();
+  srand(argc > 3 ? atoi(argv[3]) : 1);
+  if (!strcmp(mode, "golden")) {
+    status = walk_test_maps(mode, NULL, 1);
+  } else if (!strcmp(mode, "frames") && argc > 2) {
+    status = walk_test_maps(mode, argv[2], 1);
+  } else if (!strcmp(mode, "bench")) {
+    status = walk_test_maps(mode,
+                            NULL,
+                            argc > 2 ? atoi(argv[2]) : DEFAULT_BENCHMARK_REPS);
+  } else if (!strcmp(mode, "play") && argc > 2) {
+    status = play(atoi(argv[2]));
+  } else {
+    fprintf(stderr,
+            "Usage: %s golden | frames <dir> | bench [reps] | "
+            "play <seconds> [seed]\n",
+            argv[0]);
+    status = 2;
+  }
+  deinit();
+
+  return status;
+}
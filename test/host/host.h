@@ -0,0 +1,49 @@
+/*******************************************************************************
+   Filename: host.h
+
+Description: Controls for running PebbleQuest headless against the SDK
+             stand-in in "pebble.h": rendering a window into the software frame
+             buffer, dumping and hashing frames, advancing the clock (which
+             fires due timers and tick handlers) and pressing buttons. Also
+             includes the game's own header, with its "main" renamed so host
+             programs can supply their own.
+*******************************************************************************/
+
+#ifndef HOST_H_
+#define HOST_H_
+
+#define main pebble_quest_main
+#include "pebble_quest.h"
+#undef main
+
+#define HOST_SCREEN_WIDTH                144
+#define HOST_SCREEN_HEIGHT               168
+#define HOST_DEFAULT_HEAP_BYTES_FREE     60000
+#define HOST_PERSIST_STORAGE_SIZE        4096  // Bytes per app, as on a watch.
+
+// Counters, for benchmarks and for tests of how often the game does things:
+typedef struct HostCounters {
+  uint32_t draw_calls,
+           pixels_drawn,
+           persist_writes,
+           persist_bytes_written,
+           ticks;
+} HostCounters;
+
+extern HostCounters g_host_counters;
+
+GContext *host_get_graphics_context(void);
+void host_clear_frame(void);
+void host_render_window(Window *window);
+void host_render_top_window(void);
+uint8_t host_get_pixel(int16_t x, int16_t y);
+uint32_t host_frame_hash(void);
+bool host_write_ppm(const char *path);
+void host_advance_time(uint32_t milliseconds);
+void host_tick(void);
+void host_click(ButtonId button_id);
+void host_multi_click(ButtonId button_id);
+void host_set_heap_bytes_free(size_t bytes);
+void host_clear_persistent_storage(void);
+
+#endif  // HOST_H_
@@ -0,0 +1,899 @@
+/*******************************************************************************
+   Filename: pebble.c
+
+Description: Implementation of the host stand-in for the Pebble SDK declared
+             in "pebble.h", plus the host controls declared in "host.h".
+*******************************************************************************/
+
+#include <math.h>
+#include "host.h"
+
+#define HOST_MAX_WINDOWS_ON_STACK        16
+#define HOST_MAX_TIMERS                  16
+#define HOST_MAX_PERSIST_KEYS            128
+#define HOST_START_TIME_MS               1000000  // time() == 1000 at startup.
+
+struct AppTimer {
+  AppTimerCallback callback;
+  void *data;
+  uint64_t due_ms;
+  bool is_live;
+};
+
+typedef struct HostPersistEntry {
+  uint32_t key;
+  uint16_t size;
+  uint8_t data[PERSIST_DATA_MAX_LENGTH];
+  bool is_used;
+} HostPersistEntry;
+
+HostCounters g_host_counters;
+
+static uint8_t s_frame_data[HOST_SCREEN_WIDTH * HOST_SCREEN_HEIGHT];
+static GBitmap s_frame_buffer = {
+  s_frame_data,
+  HOST_SCREEN_WIDTH,
+  {{0, 0}, {HOST_SCREEN_WIDTH, HOST_SCREEN_HEIGHT}},
+};
+static GContext s_ctx = {.frame_buffer = &s_frame_buffer};
+static Window *s_window_stack[HOST_MAX_WINDOWS_ON_STACK],
+              *s_click_config_window;
+static int8_t s_window_stack_size;
+static struct AppTimer s_timers[HOST_MAX_TIMERS];
+static HostPersistEntry s_persist_entries[HOST_MAX_PERSIST_KEYS];
+static uint64_t s_time_ms = HOST_START_TIME_MS;
+static size_t s_heap_bytes_free = HOST_DEFAULT_HEAP_BYTES_FREE;
+static TickHandler s_tick_handler;
+
+/*******************************************************************************
+  Geometry and trigonometry
+*******************************************************************************/
+
+bool gpoint_equal(const GPoint *const point_a, const GPoint *const point_b) {
+  return point_a->x == point_b->x && point_a->y == point_b->y;
+}
+
+int32_t sin_lookup(int32_t angle) {
+  return (int32_t) lround(sin(angle * 2 * M_PI / TRIG_MAX_ANGLE) *
+                          TRIG_MAX_RATIO);
+}
+
+int32_t cos_lookup(int32_t angle) {
+  return (int32_t) lround(cos(angle * 2 * M_PI / TRIG_MAX_ANGLE) *
+                          TRIG_MAX_RATIO);
+}
+
+/*******************************************************************************
+  Drawing (every primitive clips to the frame buffer and counts as one call)
+*******************************************************************************/
+
+static void put_pixel(GContext *ctx, int x, int y, GColor color) {
+  GBitmap *frame_buffer = ctx->frame_buffer;
+
+  if (ctx->frame_buffer_is_captured) {
+    fprintf(stderr, "Drawing while the frame buffer is captured.\n");
+    abort();
+  }
+  if (x < 0 || y < 0 || x >= frame_buffer->bounds.size.w ||
+      y >= frame_buffer->bounds.size.h) {
+    return;
+  }
+  frame_buffer->data[y * frame_buffer->bytes_per_row + x] = color.argb;
+  g_host_counters.pixels_drawn++;
+}
+
+void graphics_context_set_stroke_color(GContext *ctx, GColor color) {
+  ctx->stroke_color = color;
+}
+
+void graphics_context_set_fill_color(GContext *ctx, GColor color) {
+  ctx->fill_color = color;
+}
+
+void graphics_draw_pixel(GContext *ctx, GPoint point) {
+  g_host_counters.draw_calls++;
+  put_pixel(ctx, point.x, point.y, ctx->stroke_color);
+}
+
+void graphics_draw_line(GContext *ctx, GPoint p0, GPoint p1) {
+  int x = p0.x,
+      y = p0.y,
+      dx = abs(p1.x - p0.x),
+      dy = -abs(p1.y - p0.y),
+      step_x = p0.x < p1.x ? 1 : -1,
+      step_y = p0.y < p1.y ? 1 : -1,
+      error = dx + dy;
+
+  g_host_counters.draw_calls++;
+  for (;;) {  // Bresenham's algorithm.
+    put_pixel(ctx, x, y, ctx->stroke_color);
+    if (x == p1.x && y == p1.y) {
+      break;
+    }
+    if (error * 2 >= dy) {
+      error += dy;
+      x += step_x;
+    }
+    if (error * 2 <= dx) {
+      error += dx;
+      y += step_y;
+    }
+  }
+}
+
+// True if a rounded corner cuts off pixel (x, y) of a rectangle:
+static bool is_outside_corner(GRect rect,
+                              int radius,
+                              GCornerMask corner_mask,
+                              int x,
+                              int y) {
+  int left = rect.origin.x + radius,
+      right = rect.origin.x + rect.size.w - radius - 1,
+      top = rect.origin.y + radius,
+      bottom = rect.origin.y + rect.size.h - radius - 1,
+      center_x = x < left ? left : right,
+      center_y = y < top ? top : bottom;
+  GCornerMask corner = y < top ? (x < left ? GCornerTopLeft : GCornerTopRight) :
+                                 (x < left ? GCornerBottomLeft :
+                                             GCornerBottomRight);
+
+  if ((x >= left && x <= right) || (y >= top && y <= bottom) ||
+      !(corner_mask & corner)) {
+    return false;
+  }
+
+  return (x - center_x) * (x - center_x) + (y - center_y) * (y - center_y) >
+           radius * radius;
+}
+
+void graphics_fill_rect(GContext *ctx,
+                        GRect rect,
+                        uint16_t corner_radius,
+                        GCornerMask corner_mask) {
+  int x, y, radius = corner_radius;
+
+  g_host_counters.draw_calls++;
+  if (rect.size.w < 0) {
+    rect.origin.x += rect.size.w;
+    rect.size.w = -rect.size.w;
+  }
+  if (rect.size.h < 0) {
+    rect.origin.y += rect.size.h;
+    rect.size.h = -rect.size.h;
+  }
+  if (radius * 2 > rect.size.w) {
+    radius = rect.size.w / 2;
+  }
+  if (radius * 2 > rect.size.h) {
+    radius = rect.size.h / 2;
+  }
+  for (y = rect.origin.y; y < rect.origin.y + rect.size.h; ++y) {
+    for (x = rect.origin.x; x < rect.origin.x + rect.size.w; ++x) {
+      if (!is_outside_corner(rect, radius, corner_mask, x, y)) {
+        put_pixel(ctx, x, y, ctx->fill_color);
+      }
+    }
+  }
+}
+
+void graphics_fill_circle(GContext *ctx, GPoint center, uint16_t radius) {
+  int x, y;
+
+  g_host_counters.draw_calls++;
+  for (y = -radius; y <= radius; ++y) {
+    for (x = -radius; x <= radius; ++x) {
+      if (x * x + y * y <= radius * radius) {
+        put_pixel(ctx, center.x + x, center.y + y, ctx->fill_color);
+      }
+    }
+  }
+}
+
+GBitmap *graphics_capture_frame_buffer(GContext *ctx) {
+  g_host_counters.draw_calls++;
+  if (ctx->frame_buffer_is_captured) {
+    return NULL;
+  }
+  ctx->frame_buffer_is_captured = true;
+
+  return ctx->frame_buffer;
+}
+
+bool graphics_release_frame_buffer(GContext *ctx, GBitmap *buffer) {
+  if (!ctx->frame_buffer_is_captured || buffer != ctx->frame_buffer) {
+    fprintf(stderr, "Releasing a frame buffer that wasn't captured.\n");
+    abort();
+  }
+  ctx->frame_buffer_is_captured = false;
+
+  return true;
+}
+
+GBitmap *gbitmap_create_blank(GSize size, GBitmapFormat format) {
+  GBitmap *bitmap;
+  uint16_t bytes_per_row = format == GBitmapFormat8Bit ? size.w :
+                                                         (size.w + 7) / 8;
+
+  if (sizeof(GBitmap) + (size_t) bytes_per_row * size.h > s_heap_bytes_free) {
+    return NULL;
+  }
+  bitmap = malloc(sizeof(GBitmap));
+  bitmap->data = calloc(size.h, bytes_per_row);
+  bitmap->bytes_per_row = bytes_per_row;
+  bitmap->bounds = GRect(0, 0, size.w, size.h);
+
+  return bitmap;
+}
+
+void gbitmap_destroy(GBitmap *bitmap) {
+  free(bitmap->data);
+  free(bitmap);
+}
+
+uint8_t *gbitmap_get_data(const GBitmap *bitmap) {
+  return bitmap->data;
+}
+
+uint16_t gbitmap_get_bytes_per_row(const GBitmap *bitmap) {
+  return bitmap->bytes_per_row;
+}
+
+GRect gbitmap_get_bounds(const GBitmap *bitmap) {
+  return bitmap->bounds;
+}
+
+GPath *gpath_create(const GPathInfo *init) {
+  GPath *path = calloc(1, sizeof(GPath));
+
+  path->num_points = init->num_points;
+  path->points = init->points;
+
+  return path;
+}
+
+void gpath_destroy(GPath *path) {
+  free(path);
+}
+
+void gpath_rotate_to(GPath *path, int32_t angle) {
+  path->rotation = angle;
+}
+
+void gpath_move_to(GPath *path, GPoint point) {
+  path->offset = point;
+}
+
+// The path's nth point after rotation and translation:
+static GPoint get_path_point(const GPath *path, uint32_t n) {
+  int32_t sin = sin_lookup(path->rotation),
+          cos = cos_lookup(path->rotation);
+  GPoint point = path->points[n % path->num_points];
+
+  return GPoint((point.x * cos - point.y * sin) / TRIG_MAX_RATIO +
+                  path->offset.x,
+                (point.x * sin + point.y * cos) / TRIG_MAX_RATIO +
+                  path->offset.y);
+}
+
+void gpath_draw_outline(GContext *ctx, GPath *path) {
+  uint32_t i;
+
+  for (i = 0; i < path->num_points; ++i) {
+    graphics_draw_line(ctx, get_path_point(path, i),
+                       get_path_point(path, i + 1));
+  }
+}
+
+void gpath_draw_filled(GContext *ctx, GPath *path) {
+  int x, y, min_x = INT16_MAX, max_x = INT16_MIN, min_y = INT16_MAX,
+      max_y = INT16_MIN;
+  uint32_t i;
+  bool is_inside;
+  GPoint a, b;
+
+  g_host_counters.draw_calls++;
+  for (i = 0; i < path->num_points; ++i) {
+    a = get_path_point(path, i);
+    min_x = a.x < min_x ? a.x : min_x;
+    max_x = a.x > max_x ? a.x : max_x;
+    min_y = a.y < min_y ? a.y : min_y;
+    max_y = a.y > max_y ? a.y : max_y;
+  }
+  for (y = min_y; y <= max_y; ++y) {
+    for (x = min_x; x <= max_x; ++x) {
+      is_inside = false;  // Even-odd rule.
+      for (i = 0; i < path->num_points; ++i) {
+        a = get_path_point(path, i);
+        b = get_path_point(path, i + 1);
+        if ((a.y > y) != (b.y > y) &&
+            x < (b.x - a.x) * (y - a.y) / (double) (b.y - a.y) + a.x) {
+          is_inside = !is_inside;
+        }
+      }
+      if (is_inside) {
+        put_pixel(ctx, x, y, ctx->fill_color);
+      }
+    }
+  }
+}
+
+/*******************************************************************************
+  Layers and windows
+*******************************************************************************/
+
+Layer *layer_create(GRect frame) {
+  Layer *layer = calloc(1, sizeof(Layer));
+
+  layer->frame = frame;
+
+  return layer;
+}
+
+void layer_destroy(Layer *layer) {
+  free(layer);
+}
+
+void layer_mark_dirty(Layer *layer) {
+  layer->is_dirty = true;
+}
+
+void layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc) {
+  layer->update_proc = update_proc;
+}
+
+void layer_add_child(Layer *parent, Layer *child) {
+  if (parent->num_children == HOST_MAX_CHILD_LAYERS) {
+    fprintf(stderr, "Too many child layers.\n");
+    abort();
+  }
+  parent->children[parent->num_children++] = child;
+}
+
+GRect layer_get_bounds(const Layer *layer) {
+  return GRect(0, 0, layer->frame.size.w, layer->frame.size.h);
+}
+
+Window *window_create(void) {
+  Window *window = calloc(1, sizeof(Window));
+
+  window->root_layer.frame = GRect(0, 0, HOST_SCREEN_WIDTH, HOST_SCREEN_HEIGHT);
+  window->background_color = GColorWhite;
+
+  return window;
+}
+
+void window_destroy(Window *window) {
+  free(window);
+}
+
+Layer *window_get_root_layer(const Window *window) {
+  return (Layer *) &window->root_layer;
+}
+
+void window_set_window_handlers(Window *window, WindowHandlers handlers) {
+  window->handlers = handlers;
+}
+
+void window_set_background_color(Window *window, GColor background_color) {
+  window->background_color = background_color;
+}
+
+void window_set_click_config_provider(Window *window,
+                                      ClickConfigProvider provider) {
+  window->click_config_provider = provider;
+}
+
+// Click subscriptions apply to the window whose provider is running:
+void window_single_click_subscribe(ButtonId button_id, ClickHandler handler) {
+  s_click_config_window->single_click_handlers[button_id] = handler;
+}
+
+void window_single_repeating_click_subscribe(ButtonId button_id,
+                                             uint16_t repeat_interval_ms,
+                                             ClickHandler handler) {
+  s_click_config_window->single_click_handlers[button_id] = handler;
+}
+
+void window_multi_click_subscribe(ButtonId button_id,
+                                  uint8_t min_clicks,
+                                  uint8_t max_clicks,
+                                  uint16_t timeout,
+                                  bool last_click_only,
+                                  ClickHandler handler) {
+  s_click_config_window->multi_click_handlers[button_id] = handler;
+}
+
+void window_stack_push(Window *window, bool animated) {
+  if (s_window_stack_size == HOST_MAX_WINDOWS_ON_STACK) {
+    fprintf(stderr, "Too many windows on the stack.\n");
+    abort();
+  }
+  if (s_window_stack_size > 0 &&
+      s_window_stack[s_window_stack_size - 1]->handlers.disappear) {
+    s_window_stack[s_window_stack_size - 1]->handlers.disappear(
+      s_window_stack[s_window_stack_size - 1]);
+  }
+  s_window_stack[s_window_stack_size++] = window;
+  if (window->click_config_provider) {
+    s_click_config_window = window;
+    window->click_config_provider(window);
+  }
+  if (window->handlers.appear) {
+    window->handlers.appear(window);
+  }
+}
+
+Window *window_stack_pop(bool animated) {
+  Window *window;
+
+  if (s_window_stack_size == 0) {
+    return NULL;
+  }
+  window = s_window_stack[--s_window_stack_size];
+  if (window->handlers.disappear) {
+    window->handlers.disappear(window);
+  }
+  if (s_window_stack_size > 0 &&
+      s_window_stack[s_window_stack_size - 1]->handlers.appear) {
+    s_window_stack[s_window_stack_size - 1]->handlers.appear(
+      s_window_stack[s_window_stack_size - 1]);
+  }
+
+  return window;
+}
+
+bool window_stack_contains_window(Window *window) {
+  int8_t i;
+
+  for (i = 0; i < s_window_stack_size; ++i) {
+    if (s_window_stack[i] == window) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+Window *window_stack_get_top_window(void) {
+  return s_window_stack_size > 0 ? s_window_stack[s_window_stack_size - 1] :
+                                   NULL;
+}
+
+/*******************************************************************************
+  Menus, text and status bars
+*******************************************************************************/
+
+MenuLayer *menu_layer_create(GRect frame) {
+  MenuLayer *menu_layer = calloc(1, sizeof(MenuLayer));
+
+  menu_layer->layer.frame = frame;
+
+  return menu_layer;
+}
+
+void menu_layer_destroy(MenuLayer *menu_layer) {
+  free(menu_layer);
+}
+
+Layer *menu_layer_get_layer(const MenuLayer *menu_layer) {
+  return (Layer *) &menu_layer->layer;
+}
+
+void menu_layer_set_click_config_onto_window(MenuLayer *menu_layer,
+                                             Window *window) {
+  window->menu_layer = menu_layer;
+}
+
+void menu_layer_set_callbacks(MenuLayer *menu_layer,
+                              void *callback_context,
+                              MenuLayerCallbacks callbacks) {
+  menu_layer->callback_context = callback_context;
+  menu_layer->callbacks = callbacks;
+}
+
+void menu_layer_reload_data(MenuLayer *menu_layer) {}
+
+void menu_layer_set_selected_index(MenuLayer *menu_layer,
+                                   MenuIndex index,
+                                   MenuRowAlign scroll_align,
+                                   bool animated) {
+  menu_layer->selected_index = index;
+}
+
+void menu_cell_basic_draw(GContext *ctx,
+                          const Layer *cell_layer,
+                          const char *title,
+                          const char *subtitle,
+                          GBitmap *icon) {}
+
+void menu_cell_basic_header_draw(GContext *ctx,
+                                 const Layer *cell_layer,
+                                 const char *title) {}
+
+TextLayer *text_layer_create(GRect frame) {
+  TextLayer *text_layer = calloc(1, sizeof(TextLayer));
+
+  text_layer->layer.frame = frame;
+
+  return text_layer;
+}
+
+void text_layer_destroy(TextLayer *text_layer) {
+  free(text_layer);
+}
+
+Layer *text_layer_get_layer(TextLayer *text_layer) {
+  return &text_layer->layer;
+}
+
+void text_layer_set_text(TextLayer *text_layer, const char *text) {
+  text_layer->text = text;
+}
+
+void text_layer_set_background_color(TextLayer *text_layer, GColor color) {}
+
+void text_layer_set_text_color(TextLayer *text_layer, GColor color) {}
+
+void text_layer_set_font(TextLayer *text_layer, GFont font) {}
+
+void text_layer_set_text_alignment(TextLayer *text_layer,
+                                   GTextAlignment text_alignment) {}
+
+StatusBarLayer *status_bar_layer_create(void) {
+  return calloc(1, sizeof(StatusBarLayer));
+}
+
+void status_bar_layer_destroy(StatusBarLayer *status_bar_layer) {
+  free(status_bar_layer);
+}
+
+Layer *status_bar_layer_get_layer(StatusBarLayer *status_bar_layer) {
+  return &status_bar_layer->layer;
+}
+
+GFont fonts_get_system_font(const char *font_key) {
+  return font_key;
+}
+
+/*******************************************************************************
+  Timers, services, time and memory
+*******************************************************************************/
+
+AppTimer *app_timer_register(uint32_t timeout_ms,
+                             AppTimerCallback callback,
+                             void *callback_data) {
+  int8_t i;
+
+  for (i = 0; i < HOST_MAX_TIMERS; ++i) {
+    if (!s_timers[i].is_live) {
+      s_timers[i] = (struct AppTimer) {callback,
+                                       callback_data,
+                                       s_time_ms + timeout_ms,
+                                       true};
+
+      return &s_timers[i];
+    }
+  }
+  fprintf(stderr, "Too many timers.\n");
+  abort();
+}
+
+bool app_timer_reschedule(AppTimer *timer, uint32_t new_timeout_ms) {
+  if (timer == NULL || !timer->is_live) {
+    return false;
+  }
+  timer->due_ms = s_time_ms + new_timeout_ms;
+
+  return true;
+}
+
+void app_timer_cancel(AppTimer *timer) {
+  if (timer != NULL) {
+    timer->is_live = false;
+  }
+}
+
+void tick_timer_service_subscribe(TimeUnits tick_units, TickHandler handler) {
+  s_tick_handler = handler;
+}
+
+void tick_timer_service_unsubscribe(void) {
+  s_tick_handler = NULL;
+}
+
+void app_focus_service_subscribe(AppFocusHandler handler) {}
+
+void app_focus_service_unsubscribe(void) {}
+
+void app_event_loop(void) {}
+
+// Replaces the C library's, so the game sees the host clock:
+time_t time(time_t *tloc) {
+  time_t seconds = s_time_ms / 1000;
+
+  if (tloc != NULL) {
+    *tloc = seconds;
+  }
+
+  return seconds;
+}
+
+uint16_t time_ms(time_t *tloc, uint16_t *out_ms) {
+  uint16_t milliseconds = s_time_ms % 1000;
+
+  time(tloc);
+  if (out_ms != NULL) {
+    *out_ms = milliseconds;
+  }
+
+  return milliseconds;
+}
+
+size_t heap_bytes_free(void) {
+  return s_heap_bytes_free;
+}
+
+void light_enable_interaction(void) {}
+
+void vibes_short_pulse(void) {}
+
+/*******************************************************************************
+  Persistent storage
+*******************************************************************************/
+
+static HostPersistEntry *find_persist_entry(const uint32_t key,
+                                            const bool create) {
+  int16_t i;
+  HostPersistEntry *unused_entry = NULL;
+
+  for (i = 0; i < HOST_MAX_PERSIST_KEYS; ++i) {
+    if (s_persist_entries[i].is_used) {
+      if (s_persist_entries[i].key == key) {
+        return &s_persist_entries[i];
+      }
+    } else if (unused_entry == NULL) {
+      unused_entry = &s_persist_entries[i];
+    }
+  }
+  if (!create || unused_entry == NULL) {
+    return NULL;
+  }
+  unused_entry->key = key;
+  unused_entry->size = 0;
+  unused_entry->is_used = true;
+
+  return unused_entry;
+}
+
+bool persist_exists(const uint32_t key) {
+  return find_persist_entry(key, false) != NULL;
+}
+
+int32_t persist_read_int(const uint32_t key) {
+  int32_t value = 0;
+
+  persist_read_data(key, &value, sizeof(value));
+
+  return value;
+}
+
+int persist_read_data(const uint32_t key,
+                      void *buffer,
+                      const size_t buffer_size) {
+  HostPersistEntry *entry = find_persist_entry(key, false);
+  size_t size;
+
+  if (entry == NULL) {
+    return E_DOES_NOT_EXIST;
+  }
+  size = buffer_size < entry->size ? buffer_size : entry->size;
+  memcpy(buffer, entry->data, size);
+
+  return (int) size;
+}
+
+int persist_write_int(const uint32_t key, const int32_t value) {
+  const int result = persist_write_data(key, &value, sizeof(value));
+
+  return result < 0 ? result : S_SUCCESS;
+}
+
+// Like the firmware, writes at most PERSIST_DATA_MAX_LENGTH bytes per key, and
+// fails once the app's storage is full:
+int persist_write_data(const uint32_t key,
+                       const void *data,
+                       const size_t size) {
+  int16_t i;
+  uint32_t bytes_stored = 0;
+  HostPersistEntry *entry = find_persist_entry(key, false);
+  const uint16_t size_written = size < PERSIST_DATA_MAX_LENGTH ?
+                                  size : PERSIST_DATA_MAX_LENGTH;
+
+  for (i = 0; i < HOST_MAX_PERSIST_KEYS; ++i) {
+    if (s_persist_entries[i].is_used && &s_persist_entries[i] != entry) {
+      bytes_stored += s_persist_entries[i].size;
+    }
+  }
+  if (bytes_stored + size_written > HOST_PERSIST_STORAGE_SIZE) {
+    return E_OUT_OF_STORAGE;
+  }
+  if (entry == NULL && (entry = find_persist_entry(key, true)) == NULL) {
+    fprintf(stderr, "Too many persistent storage keys.\n");
+    abort();
+  }
+  entry->size = size_written;
+  memcpy(entry->data, data, entry->size);
+  g_host_counters.persist_writes++;
+  g_host_counters.persist_bytes_written += entry->size;
+
+  return entry->size;
+}
+
+int persist_delete(const uint32_t key) {
+  HostPersistEntry *entry = find_persist_entry(key, false);
+
+  if (entry == NULL) {
+    return E_DOES_NOT_EXIST;
+  }
+  entry->is_used = false;
+
+  return S_SUCCESS;
+}
+
+/*******************************************************************************
+  Host controls (see "host.h")
+*******************************************************************************/
+
+static void render_layer(Layer *layer) {
+  int8_t i;
+
+  if (layer->update_proc) {
+    layer->update_proc(layer, &s_ctx);
+  }
+  layer->is_dirty = false;
+  for (i = 0; i < layer->num_children; ++i) {
+    render_layer(layer->children[i]);
+  }
+}
+
+GContext *host_get_graphics_context(void) {
+  return &s_ctx;
+}
+
+void host_clear_frame(void) {
+  memset(s_frame_data, 0, sizeof(s_frame_data));
+}
+
+void host_render_window(Window *window) {
+  memset(s_frame_data, window->background_color.argb, sizeof(s_frame_data));
+  render_layer(&window->root_layer);
+}
+
+void host_render_top_window(void) {
+  if (s_window_stack_size > 0) {
+    host_render_window(s_window_stack[s_window_stack_size - 1]);
+  }
+}
+
+uint8_t host_get_pixel(int16_t x, int16_t y) {
+  return s_frame_data[y * HOST_SCREEN_WIDTH + x];
+}
+
+// FNV-1a, as used by the game's own frame checksums:
+uint32_t host_frame_hash(void) {
+  uint32_t hash = 2166136261u;
+  size_t i;
+
+  for (i = 0; i < sizeof(s_frame_data); ++i) {
+    hash = (hash ^ s_frame_data[i]) * 16777619u;
+  }
+
+  return hash;
+}
+
+bool host_write_ppm(const char *path) {
+  size_t i;
+  uint8_t pixel[3];
+  FILE *file = fopen(path, "wb");
+
+  if (file == NULL) {
+    return false;
+  }
+  fprintf(file, "P6\n%d %d\n255\n", HOST_SCREEN_WIDTH, HOST_SCREEN_HEIGHT);
+  for (i = 0; i < sizeof(s_frame_data); ++i) {
+    pixel[0] = ((s_frame_data[i] >> 4) & 3) * 85;
+    pixel[1] = ((s_frame_data[i] >> 2) & 3) * 85;
+    pixel[2] = (s_frame_data[i] & 3) * 85;
+    fwrite(pixel, 1, sizeof(pixel), file);
+  }
+
+  return fclose(file) == 0;
+}
+
+// Fires due timers in order, and the tick handler on each new second:
+void host_advance_time(uint32_t milliseconds) {
+  int8_t i, next_timer;
+  uint64_t end_ms = s_time_ms + milliseconds,
+           next_second_ms;
+  time_t seconds;
+
+  for (;;) {
+    next_timer = NONE;
+    for (i = 0; i < HOST_MAX_TIMERS; ++i) {
+      if (s_timers[i].is_live && s_timers[i].due_ms <= end_ms &&
+          (next_timer == NONE ||
+           s_timers[i].due_ms < s_timers[next_timer].due_ms)) {
+        next_timer = i;
+      }
+    }
+    next_second_ms = (s_time_ms / 1000 + 1) * 1000;
+    if (next_second_ms <= end_ms &&
+        (next_timer == NONE || next_second_ms <= s_timers[next_timer].due_ms)) {
+      s_time_ms = next_second_ms;
+      if (s_tick_handler) {
+        seconds = time(NULL);
+        g_host_counters.ticks++;
+        s_tick_handler(localtime(&seconds), SECOND_UNIT);
+      }
+    } else if (next_timer != NONE) {
+      s_time_ms = s_timers[next_timer].due_ms;
+      s_timers[next_timer].is_live = false;
+      s_timers[next_timer].callback(s_timers[next_timer].data);
+    } else {
+      break;
+    }
+  }
+  s_time_ms = end_ms;
+}
+
+void host_tick(void) {
+  host_advance_time(1000 - s_time_ms % 1000);
+}
+
+// Menus take UP/DOWN/SELECT themselves; BACK pops unless a handler is set:
+void host_click(ButtonId button_id) {
+  Window *window = window_stack_get_top_window();
+  MenuLayer *menu_layer;
+  uint16_t num_rows;
+
+  if (window == NULL) {
+    return;
+  }
+  menu_layer = window->menu_layer;
+  if (menu_layer != NULL && button_id != BUTTON_ID_BACK) {
+    num_rows = menu_layer->callbacks.get_num_rows(menu_layer,
+                                                  0,
+                                                  menu_layer->callback_context);
+    if (button_id == BUTTON_ID_UP && menu_layer->selected_index.row > 0) {
+      menu_layer->selected_index.row--;
+    } else if (button_id == BUTTON_ID_DOWN &&
+               menu_layer->selected_index.row + 1 < num_rows) {
+      menu_layer->selected_index.row++;
+    } else if (button_id == BUTTON_ID_SELECT &&
+               menu_layer->callbacks.select_click) {
+      menu_layer->callbacks.select_click(menu_layer,
+                                         &menu_layer->selected_index,
+                                         menu_layer->callback_context);
+    }
+  } else if (window->single_click_handlers[button_id]) {
+    window->single_click_handlers[button_id](NULL, window);
+  } else if (button_id == BUTTON_ID_BACK) {
+    window_stack_pop(false);
+  }
+}
+
+void host_multi_click(ButtonId button_id) {
+  Window *window = window_stack_get_top_window();
+
+  if (window != NULL && window->multi_click_handlers[button_id]) {
+    window->multi_click_handlers[button_id](NULL, window);
+  }
+}
+
+void host_set_heap_bytes_free(size_t bytes) {
+  s_heap_bytes_free = bytes;
+}
+
+void host_clear_persistent_storage(void) {
+  memset(s_persist_entries, 0, sizeof(s_persist_entries));
+}
@@ -0,0 +1,432 @@
+/*******************************************************************************
+   Filename: pebble.h
+
+Description: Host stand-in for the parts of the Pebble SDK 3 (basalt) API that
+             PebbleQuest uses, so "src/pebble_quest.c" can be compiled and run
+             headless on a desktop machine. Drawing goes to a software 144x168
+             8-bit frame buffer; storage, timers, ticks and clicks are driven
+             by the functions declared in "host.h". Only what the game calls
+             is provided, and rasterization only approximates the firmware's
+             (it is deterministic, which is what golden-image checks need).
+*******************************************************************************/
+
+#ifndef HOST_PEBBLE_H_
+#define HOST_PEBBLE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*******************************************************************************
+  Geometry
+*******************************************************************************/
+
+typedef struct GPoint {
+  int16_t x,
+          y;
+} GPoint;
+
+typedef struct GSize {
+  int16_t w,
+          h;
+} GSize;
+
+typedef struct GRect {
+  GPoint origin;
+  GSize size;
+} GRect;
+
+#define GPoint(x, y)                     ((GPoint) {(x), (y)})
+#define GPointZero                       GPoint(0, 0)
+#define GSize(w, h)                      ((GSize) {(w), (h)})
+#define GRect(x, y, w, h)                ((GRect) {{(x), (y)}, {(w), (h)}})
+
+bool gpoint_equal(const GPoint *const point_a, const GPoint *const point_b);
+
+/*******************************************************************************
+  Colors (8-bit ARGB, two bits per channel)
+*******************************************************************************/
+
+typedef union GColor8 {
+  uint8_t argb;
+  struct {
+    uint8_t b : 2,
+            g : 2,
+            r : 2,
+            a : 2;
+  };
+} GColor8;
+
+typedef GColor8 GColor;
+
+#define HOST_COLOR(argb_value)           ((GColor8) {.argb = (argb_value)})
+#define GColorFromRGB(red, green, blue)  HOST_COLOR(0xC0 |                    \
+                                                    ((red) >> 6) << 4 |       \
+                                                    ((green) >> 6) << 2 |     \
+                                                    (blue) >> 6)
+
+#define GColorClear                      HOST_COLOR(0x00)
+#define GColorBlack                      HOST_COLOR(0xC0)
+#define GColorOxfordBlue                 HOST_COLOR(0xC1)
+#define GColorDukeBlue                   HOST_COLOR(0xC2)
+#define GColorBlue                       HOST_COLOR(0xC3)
+#define GColorDarkGreen                  HOST_COLOR(0xC4)
+#define GColorMidnightGreen              HOST_COLOR(0xC5)
+#define GColorIslamicGreen               HOST_COLOR(0xC8)
+#define GColorVividCerulean              HOST_COLOR(0xCB)
+#define GColorGreen                      HOST_COLOR(0xCC)
+#define GColorMediumSpringGreen          HOST_COLOR(0xCE)
+#define GColorBulgarianRose              HOST_COLOR(0xD0)
+#define GColorImperialPurple             HOST_COLOR(0xD1)
+#define GColorPurple                     HOST_COLOR(0xD2)
+#define GColorVeryLightBlue              HOST_COLOR(0xD3)
+#define GColorDarkGray                   HOST_COLOR(0xD5)
+#define GColorCadetBlue                  HOST_COLOR(0xD6)
+#define GColorPictonBlue                 HOST_COLOR(0xD7)
+#define GColorMediumAquamarine           HOST_COLOR(0xDA)
+#define GColorTiffanyBlue                HOST_COLOR(0xDB)
+#define GColorBrightGreen                HOST_COLOR(0xDD)
+#define GColorElectricBlue               HOST_COLOR(0xDF)
+#define GColorDarkCandyAppleRed          HOST_COLOR(0xE0)
+#define GColorJazzberryJam               HOST_COLOR(0xE1)
+#define GColorVividViolet                HOST_COLOR(0xE3)
+#define GColorArmyGreen                  HOST_COLOR(0xE4)
+#define GColorWindsorTan                 HOST_COLOR(0xE5)
+#define GColorLavenderIndigo             HOST_COLOR(0xE7)
+#define GColorLimerick                   HOST_COLOR(0xE8)
+#define GColorBrass                      HOST_COLOR(0xE9)
+#define GColorLightGray                  HOST_COLOR(0xEA)
+#define GColorBabyBlueEyes               HOST_COLOR(0xEB)
+#define GColorSpringBud                  HOST_COLOR(0xED)
+#define GColorMintGreen                  HOST_COLOR(0xEE)
+#define GColorCeleste                    HOST_COLOR(0xEF)
+#define GColorRed                        HOST_COLOR(0xF0)
+#define GColorFolly                      HOST_COLOR(0xF1)
+#define GColorFashionMagenta             HOST_COLOR(0xF2)
+#define GColorMagenta                    HOST_COLOR(0xF3)
+#define GColorOrange                     HOST_COLOR(0xF4)
+#define GColorSunsetOrange               HOST_COLOR(0xF5)
+#define GColorShockingPink               HOST_COLOR(0xF7)
+#define GColorChromeYellow               HOST_COLOR(0xF8)
+#define GColorRajah                      HOST_COLOR(0xF9)
+#define GColorMelon                      HOST_COLOR(0xFA)
+#define GColorRichBrilliantLavender      HOST_COLOR(0xFB)
+#define GColorYellow                     HOST_COLOR(0xFC)
+#define GColorIcterine                   HOST_COLOR(0xFD)
+#define GColorPastelYellow               HOST_COLOR(0xFE)
+#define GColorWhite                      HOST_COLOR(0xFF)
+
+/*******************************************************************************
+  Bitmaps, paths and graphics contexts
+*******************************************************************************/
+
+typedef enum {
+  GBitmapFormat1Bit,
+  GBitmapFormat8Bit,
+} GBitmapFormat;
+
+typedef enum {
+  GCornerNone        = 0,
+  GCornerTopLeft     = 1,
+  GCornerTopRight    = 2,
+  GCornerBottomLeft  = 4,
+  GCornerBottomRight = 8,
+  GCornersTop        = GCornerTopLeft | GCornerTopRight,
+  GCornersBottom     = GCornerBottomLeft | GCornerBottomRight,
+  GCornersLeft       = GCornerTopLeft | GCornerBottomLeft,
+  GCornersRight      = GCornerTopRight | GCornerBottomRight,
+  GCornersAll        = GCornersTop | GCornersBottom,
+} GCornerMask;
+
+typedef struct GBitmap {
+  uint8_t *data;
+  uint16_t bytes_per_row;
+  GRect bounds;
+} GBitmap;
+
+typedef struct GContext {
+  GBitmap *frame_buffer;
+  GColor stroke_color,
+         fill_color;
+  bool frame_buffer_is_captured;
+} GContext;
+
+typedef struct GPathInfo {
+  uint32_t num_points;
+  GPoint *points;
+} GPathInfo;
+
+typedef struct GPath {
+  uint32_t num_points;
+  GPoint *points,
+         offset;
+  int32_t rotation;
+} GPath;
+
+#define TRIG_MAX_ANGLE                   0x10000
+#define TRIG_MAX_RATIO                   0xffff
+
+int32_t sin_lookup(int32_t angle);
+int32_t cos_lookup(int32_t angle);
+
+void graphics_context_set_stroke_color(GContext *ctx, GColor color);
+void graphics_context_set_fill_color(GContext *ctx, GColor color);
+void graphics_draw_pixel(GContext *ctx, GPoint point);
+void graphics_draw_line(GContext *ctx, GPoint p0, GPoint p1);
+void graphics_fill_rect(GContext *ctx,
+                        GRect rect,
+                        uint16_t corner_radius,
+                        GCornerMask corner_mask);
+void graphics_fill_circle(GContext *ctx, GPoint center, uint16_t radius);
+GBitmap *graphics_capture_frame_buffer(GContext *ctx);
+bool graphics_release_frame_buffer(GContext *ctx, GBitmap *buffer);
+GBitmap *gbitmap_create_blank(GSize size, GBitmapFormat format);
+void gbitmap_destroy(GBitmap *bitmap);
+uint8_t *gbitmap_get_data(const GBitmap *bitmap);
+uint16_t gbitmap_get_bytes_per_row(const GBitmap *bitmap);
+GRect gbitmap_get_bounds(const GBitmap *bitmap);
+GPath *gpath_create(const GPathInfo *init);
+void gpath_destroy(GPath *path);
+void gpath_rotate_to(GPath *path, int32_t angle);
+void gpath_move_to(GPath *path, GPoint point);
+void gpath_draw_filled(GContext *ctx, GPath *path);
+void gpath_draw_outline(GContext *ctx, GPath *path);
+
+/*******************************************************************************
+  Layers and windows
+*******************************************************************************/
+
+#define HOST_MAX_CHILD_LAYERS            4
+#define NUM_BUTTONS                      4
+
+typedef enum {
+  BUTTON_ID_BACK,
+  BUTTON_ID_UP,
+  BUTTON_ID_SELECT,
+  BUTTON_ID_DOWN,
+} ButtonId;
+
+typedef struct Layer Layer;
+typedef struct Window Window;
+typedef void (*LayerUpdateProc)(Layer *layer, GContext *ctx);
+typedef void (*WindowHandler)(Window *window);
+typedef void *ClickRecognizerRef;
+typedef void (*ClickHandler)(ClickRecognizerRef recognizer, void *context);
+typedef void (*ClickConfigProvider)(void *context);
+
+struct Layer {
+  GRect frame;
+  LayerUpdateProc update_proc;
+  Layer *children[HOST_MAX_CHILD_LAYERS];
+  int8_t num_children;
+  bool is_dirty;
+};
+
+typedef struct WindowHandlers {
+  WindowHandler load,
+                appear,
+                disappear,
+                unload;
+} WindowHandlers;
+
+struct Window {
+  Layer root_layer;
+  WindowHandlers handlers;
+  ClickConfigProvider click_config_provider;
+  ClickHandler single_click_handlers[NUM_BUTTONS],
+               multi_click_handlers[NUM_BUTTONS];
+  GColor background_color;
+  struct MenuLayer *menu_layer;  // Receives the window's clicks, if set.
+};
+
+Layer *layer_create(GRect frame);
+void layer_destroy(Layer *layer);
+void layer_mark_dirty(Layer *layer);
+void layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc);
+void layer_add_child(Layer *parent, Layer *child);
+GRect layer_get_bounds(const Layer *layer);
+Window *window_create(void);
+void window_destroy(Window *window);
+Layer *window_get_root_layer(const Window *window);
+void window_set_window_handlers(Window *window, WindowHandlers handlers);
+void window_set_background_color(Window *window, GColor background_color);
+void window_set_click_config_provider(Window *window,
+                                      ClickConfigProvider provider);
+void window_single_click_subscribe(ButtonId button_id, ClickHandler handler);
+void window_single_repeating_click_subscribe(ButtonId button_id,
+                                             uint16_t repeat_interval_ms,
+                                             ClickHandler handler);
+void window_multi_click_subscribe(ButtonId button_id,
+                                  uint8_t min_clicks,
+                                  uint8_t max_clicks,
+                                  uint16_t timeout,
+                                  bool last_click_only,
+                                  ClickHandler handler);
+void window_stack_push(Window *window, bool animated);
+Window *window_stack_pop(bool animated);
+bool window_stack_contains_window(Window *window);
+Window *window_stack_get_top_window(void);
+
+/*******************************************************************************
+  Menus, text and status bars (laid out, but not drawn)
+*******************************************************************************/
+
+typedef struct MenuIndex {
+  uint16_t section,
+           row;
+} MenuIndex;
+
+typedef enum {
+  MenuRowAlignNone,
+  MenuRowAlignCenter,
+  MenuRowAlignTop,
+  MenuRowAlignBottom,
+} MenuRowAlign;
+
+typedef enum {
+  GTextAlignmentLeft,
+  GTextAlignmentCenter,
+  GTextAlignmentRight,
+} GTextAlignment;
+
+typedef struct MenuLayer MenuLayer;
+typedef struct TextLayer TextLayer;
+typedef struct StatusBarLayer StatusBarLayer;
+typedef const char *GFont;
+
+typedef struct MenuLayerCallbacks {
+  uint16_t (*get_num_sections)(MenuLayer *menu_layer, void *data);
+  uint16_t (*get_num_rows)(MenuLayer *menu_layer,
+                           uint16_t section_index,
+                           void *data);
+  int16_t (*get_header_height)(MenuLayer *menu_layer,
+                               uint16_t section_index,
+                               void *data);
+  void (*draw_header)(GContext *ctx,
+                      const Layer *cell_layer,
+                      uint16_t section_index,
+                      void *data);
+  void (*draw_row)(GContext *ctx,
+                   const Layer *cell_layer,
+                   MenuIndex *cell_index,
+                   void *data);
+  void (*select_click)(MenuLayer *menu_layer,
+                       MenuIndex *cell_index,
+                       void *data);
+} MenuLayerCallbacks;
+
+struct MenuLayer {
+  Layer layer;
+  MenuLayerCallbacks callbacks;
+  void *callback_context;
+  MenuIndex selected_index;
+};
+
+struct TextLayer {
+  Layer layer;
+  const char *text;
+};
+
+struct StatusBarLayer {
+  Layer layer;
+};
+
+#define MENU_CELL_BASIC_HEADER_HEIGHT    16
+#define FONT_KEY_GOTHIC_24_BOLD          "GOTHIC_24_BOLD"
+
+MenuLayer *menu_layer_create(GRect frame);
+void menu_layer_destroy(MenuLayer *menu_layer);
+Layer *menu_layer_get_layer(const MenuLayer *menu_layer);
+void menu_layer_set_click_config_onto_window(MenuLayer *menu_layer,
+                                             Window *window);
+void menu_layer_set_callbacks(MenuLayer *menu_layer,
+                              void *callback_context,
+                              MenuLayerCallbacks callbacks);
+void menu_layer_reload_data(MenuLayer *menu_layer);
+void menu_layer_set_selected_index(MenuLayer *menu_layer,
+                                   MenuIndex index,
+                                   MenuRowAlign scroll_align,
+                                   bool animated);
+void menu_cell_basic_draw(GContext *ctx,
+                          const Layer *cell_layer,
+                          const char *title,
+                          const char *subtitle,
+                          GBitmap *icon);
+void menu_cell_basic_header_draw(GContext *ctx,
+                                 const Layer *cell_layer,
+                                 const char *title);
+TextLayer *text_layer_create(GRect frame);
+void text_layer_destroy(TextLayer *text_layer);
+Layer *text_layer_get_layer(TextLayer *text_layer);
+void text_layer_set_text(TextLayer *text_layer, const char *text);
+void text_layer_set_background_color(TextLayer *text_layer, GColor color);
+void text_layer_set_text_color(TextLayer *text_layer, GColor color);
+void text_layer_set_font(TextLayer *text_layer, GFont font);
+void text_layer_set_text_alignment(TextLayer *text_layer,
+                                   GTextAlignment text_alignment);
+StatusBarLayer *status_bar_layer_create(void);
+void status_bar_layer_destroy(StatusBarLayer *status_bar_layer);
+Layer *status_bar_layer_get_layer(StatusBarLayer *status_bar_layer);
+GFont fonts_get_system_font(const char *font_key);
+
+/*******************************************************************************
+  Timers, services and logging
+*******************************************************************************/
+
+typedef enum {
+  SECOND_UNIT = 1 << 0,
+  MINUTE_UNIT = 1 << 1,
+} TimeUnits;
+
+typedef struct AppTimer AppTimer;
+typedef void (*AppTimerCallback)(void *data);
+typedef void (*TickHandler)(struct tm *tick_time, TimeUnits units_changed);
+typedef void (*AppFocusHandler)(bool in_focus);
+
+#define APP_LOG_LEVEL_ERROR              1
+#define APP_LOG_LEVEL_WARNING            50
+#define APP_LOG_LEVEL_INFO               100
+#define APP_LOG_LEVEL_DEBUG              200
+#define APP_LOG(level, fmt, ...)         fprintf(stderr,                      \
+                                                 fmt "\n",                    \
+                                                 ##__VA_ARGS__)
+
+AppTimer *app_timer_register(uint32_t timeout_ms,
+                             AppTimerCallback callback,
+                             void *callback_data);
+bool app_timer_reschedule(AppTimer *timer, uint32_t new_timeout_ms);
+void app_timer_cancel(AppTimer *timer);
+void tick_timer_service_subscribe(TimeUnits tick_units, TickHandler handler);
+void tick_timer_service_unsubscribe(void);
+void app_focus_service_subscribe(AppFocusHandler handler);
+void app_focus_service_unsubscribe(void);
+void app_event_loop(void);
+uint16_t time_ms(time_t *tloc, uint16_t *out_ms);
+size_t heap_bytes_free(void);
+void light_enable_interaction(void);
+void vibes_short_pulse(void);
+
+/*******************************************************************************
+  Persistent storage
+*******************************************************************************/
+
+#define PERSIST_DATA_MAX_LENGTH          256
+#define S_SUCCESS                        0
+#define E_DOES_NOT_EXIST                 (-4)
+#define E_OUT_OF_STORAGE                 (-6)
+
+bool persist_exists(const uint32_t key);
+int32_t persist_read_int(const uint32_t key);
+int persist_read_data(const uint32_t key,
+                      void *buffer,
+                      const size_t buffer_size);
+int persist_write_int(const uint32_t key, const int32_t value);
+int persist_write_data(const uint32_t key,
+                       const void *data,
+                       const size_t size);
+int persist_delete(const uint32_t key);
+
+#endif  // HOST_PEBBLE_H_
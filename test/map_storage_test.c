@@ -0,0 +1,564 @@
+/*******************************************************************************
+   Filename: map_storage_test.c
+
+Description: Checks the location's side table of exits and loot, and how
+             locations are saved:
+
+               - Loot fills the table up to its last entry and no further
+                 (the cell is left EMPTY, and "set_cell_type" says so), while
+                 an exit still fits.
+               - After random edits via "set_cell_type", every cell's type
+                 equals that of a plain map, and the table stays sorted.
+               - "save_location" then "load_location" restores the location,
+                 NPCs included.
+               - A location saved with other map dimensions isn't loaded.
+               - A location saved by an older version is converted.
+               - The player and the largest possible location (a full table
+                 and NPC pool) fit in the app's 4 KB of storage, and a save
+                 that doesn't fit is reported.
+
+             Then (with "bench") times lookups in a full table against a
+             linear scan.
+
+               map_storage_test [bench] [seed]
+*******************************************************************************/
+
+#include "host.h"
+
+#define NUM_RANDOM_EDITS                 100000
+#define NUM_TEST_NPCS                    8
+#define BENCHMARK_REPS                   2000
+
+static int8_t s_map[MAP_WIDTH][MAP_HEIGHT];  // Expected cell types.
+static int16_t s_num_special_cells;  // Expected side table entries.
+
+/*******************************************************************************
+   Function: get_time_in_ns
+
+Description: Reads the host's monotonic clock.
+
+     Inputs: None.
+
+    Outputs: Nanoseconds since an arbitrary starting point.
+*******************************************************************************/
+static uint64_t get_time_in_ns(void) {
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (uint64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+/*******************************************************************************
+   Function: reset_map
+
+Description: Makes the current location, and the expected map, entirely
+             solid.
+
+     Inputs: None.
+
+    Outputs: None.
+*******************************************************************************/
+static void reset_map(void) {
+  int8_t i;
+
+  for (i = 0; i < MAX_NPCS_AT_ONE_TIME; ++i) {
+    g_location->npcs[i].type = NONE;
+  }
+  init_npc_pool();
+  clear_map();
+  g_player->position = GPoint(NONE, NONE);
+  memset(s_map, SOLID, sizeof(s_map));
+  s_num_special_cells = 0;
+}
+
+/*******************************************************************************
+   Function: edit_cell
+
+Description: Sets a cell's type via "set_cell_type" and in the expected map,
+             where loot that finds the table full (bar the exit's entry)
+             leaves the cell EMPTY.
+
+     Inputs: cell - Coordinates of the cell of interest.
+             type - The cell type to be assigned.
+
+    Outputs: "False" if "set_cell_type" didn't report what was expected.
+*******************************************************************************/
+static bool edit_cell(const GPoint cell, const int8_t type) {
+  const bool was_special = s_map[cell.x][cell.y] >= EXIT,
+             fits = type < EXIT ||
+                    was_special ||
+                    s_num_special_cells <
+                      MAX_SPECIAL_CELLS - (type == EXIT ? 0 : 1);
+
+  s_num_special_cells += (type >= EXIT && fits) - was_special;
+  s_map[cell.x][cell.y] = fits ? type : EMPTY;
+
+  return set_cell_type(cell, type) == fits;
+}
+
+/*******************************************************************************
+   Function: check_map
+
+Description: Compares every cell's type with the expected map, and checks that
+             the side table is sorted, holds no more than it should, and is
+             searched correctly.
+
+     Inputs: None.
+
+    Outputs: A description of the first problem found, or NULL if none.
+*******************************************************************************/
+static const char *check_map(void) {
+  int8_t x, y;
+  int16_t i;
+  const special_cell_t *const special_cells = g_location->special_cells;
+
+  if (g_location->num_special_cells != s_num_special_cells) {
+    return "the side table holds the wrong number of entries";
+  }
+  for (i = 1; i < g_location->num_special_cells; ++i) {
+    if (SPECIAL_CELL_INDEX(special_cells[i - 1]) >=
+          SPECIAL_CELL_INDEX(special_cells[i])) {
+      return "the side table isn't sorted";
+    }
+  }
+  for (x = 0; x < MAP_WIDTH; ++x) {
+    for (y = 0; y < MAP_HEIGHT; ++y) {
+      if (get_cell_type(GPoint(x, y)) != s_map[x][y]) {
+        return "a cell's type differs from the plain map's";
+      }
+      if ((find_special_cell(g_location, GPoint(x, y)) != NONE) !=
+            (s_map[x][y] >= EXIT)) {
+        return "a cell is (or isn't) found in the side table by mistake";
+      }
+    }
+  }
+
+  return NULL;
+}
+
+/*******************************************************************************
+   Function: report
+
+Description: Prints a test's outcome.
+
+     Inputs: name    - The test's name.
+             problem - A description of the problem found, or NULL if none.
+
+    Outputs: 1 if a problem was found, else 0.
+*******************************************************************************/
+static int report(const char *name, const char *problem) {
+  printf("%s: %s\n", name, problem ? problem : "ok");
+
+  return problem != NULL;
+}
+
+/*******************************************************************************
+   Function: test_full_table
+
+Description: Opens every cell of the map, in random order, with loot until the
+             table refuses it, swaps some loot for more, then adds an exit and
+             a second exit.
+
+     Inputs: None.
+
+    Outputs: A description of the first problem found, or NULL if none.
+*******************************************************************************/
+static const char *test_full_table(void) {
+  int16_t i, j, num_loot = 0;
+  GPoint cell, cells[MAP_WIDTH * MAP_HEIGHT];
+
+  reset_map();
+  for (i = 0; i < MAP_WIDTH * MAP_HEIGHT; ++i) {
+    j = rand() % (i + 1);
+    cells[i] = cells[j];
+    cells[j] = GPoint(i % MAP_WIDTH, i / MAP_WIDTH);
+  }
+  for (i = 0; i < MAP_WIDTH * MAP_HEIGHT - 2; ++i) {
+    if (!edit_cell(cells[i], RANDOM_ITEM)) {
+      return "loot was refused too early, or stored in the exit's entry";
+    }
+    num_loot += s_map[cells[i].x][cells[i].y] > EXIT;
+  }
+  if (num_loot != MAX_SPECIAL_CELLS - 1) {
+    return "loot didn't fill the table up to the exit's entry";
+  }
+  cell = cells[0];
+  if (!edit_cell(cell, EMPTY) || !edit_cell(cell, SHIELD) ||
+      get_cell_type(cell) != SHIELD) {
+    return "loot didn't fit in the entry freed for it";
+  }
+  if (!edit_cell(cells[i], EXIT) || get_cell_type(cells[i]) != EXIT) {
+    return "the exit didn't fit in a table full of loot";
+  }
+  if (!edit_cell(cells[i + 1], EXIT)) {
+    return "a second exit overflowed the table";
+  }
+
+  return check_map();
+}
+
+/*******************************************************************************
+   Function: test_random_edits
+
+Description: Makes random edits, of every kind, checking the whole map every
+             so often.
+
+     Inputs: None.
+
+    Outputs: A description of the first problem found, or NULL if none.
+*******************************************************************************/
+static const char *test_random_edits(void) {
+  long i;
+  const int8_t types[] = {SOLID, EMPTY, EXIT, SHIELD, RANDOM_ITEM};
+  const char *problem;
+
+  reset_map();
+  for (i = 0; i < NUM_RANDOM_EDITS; ++i) {
+    if (!edit_cell(GPoint(rand() % MAP_WIDTH, rand() % MAP_HEIGHT),
+                   types[rand() % (sizeof(types) / sizeof(types[0]))])) {
+      return "\"set_cell_type\" misreported whether a cell fit";
+    }
+    if (i % (NUM_RANDOM_EDITS / 1000) == 0 && (problem = check_map())) {
+      return problem;
+    }
+  }
+
+  return check_map();
+}
+
+/*******************************************************************************
+   Function: load_random_location
+
+Description: Replaces the current location with random terrain, exits, loot
+             and NPCs.
+
+     Inputs: None.
+
+    Outputs: None.
+*******************************************************************************/
+static void load_random_location(void) {
+  int16_t i;
+  const int8_t types[] = {SOLID, EMPTY, EMPTY, SHIELD};
+
+  reset_map();
+  for (i = 0; i < MAP_WIDTH * MAP_HEIGHT; ++i) {
+    edit_cell(GPoint(i % MAP_WIDTH, i / MAP_WIDTH),
+              types[rand() % (sizeof(types) / sizeof(types[0]))]);
+  }
+  edit_cell(RANDOM_POINT_EAST, EXIT);
+  for (i = 0; i < NUM_TEST_NPCS; ++i) {
+    add_new_npc(rand() % NUM_NPC_TYPES,
+                GPoint(rand() % MAP_WIDTH, rand() % MAP_HEIGHT));
+  }
+  g_location->floor_color_scheme = rand() % NUM_BACKGROUND_COLOR_SCHEMES;
+  g_location->wall_color_scheme = rand() % NUM_BACKGROUND_COLOR_SCHEMES;
+  g_location->entrance = RANDOM_POINT_WEST;
+  g_location->tick_count = rand();
+}
+
+/*******************************************************************************
+   Function: test_round_trip
+
+Description: Saves a random location, scrambles it, loads it back and compares
+             it with the original (NPCs in the order they're listed as live).
+
+     Inputs: None.
+
+    Outputs: A description of the first problem found, or NULL if none.
+*******************************************************************************/
+static const char *test_round_trip(void) {
+  int8_t i;
+  static location_t saved;
+  const uint32_t bytes_written = g_host_counters.persist_bytes_written,
+                 writes = g_host_counters.persist_writes;
+
+  load_random_location();
+  saved = *g_location;
+  host_clear_persistent_storage();
+  if (!save_location()) {
+    return "the location wasn't saved";
+  }
+  printf("saved %dx%d location: %lu bytes in %lu keys (%d-entry table, "
+         "%d used)\n",
+         MAP_WIDTH,
+         MAP_HEIGHT,
+         (unsigned long) (g_host_counters.persist_bytes_written -
+                            bytes_written),
+         (unsigned long) (g_host_counters.persist_writes - writes),
+         MAX_SPECIAL_CELLS,
+         saved.num_special_cells);
+  reset_map();
+  g_location->tick_count = 0;
+  if (!load_location()) {
+    return "the location wasn't loaded";
+  }
+  if (memcmp(g_location->terrain, saved.terrain, TERRAIN_SIZE) ||
+      g_location->num_special_cells != saved.num_special_cells ||
+      memcmp(g_location->special_cells,
+             saved.special_cells,
+             saved.num_special_cells * sizeof(special_cell_t))) {
+    return "the map differs";
+  }
+  if (g_location->floor_color_scheme != saved.floor_color_scheme ||
+      g_location->wall_color_scheme != saved.wall_color_scheme ||
+      !gpoint_equal(&g_location->entrance, &saved.entrance) ||
+      g_location->tick_count != saved.tick_count) {
+    return "the header differs";
+  }
+  if (g_location->num_active_npcs != saved.num_active_npcs) {
+    return "the number of NPCs differs";
+  }
+  for (i = 0; i < saved.num_active_npcs; ++i) {
+    if (memcmp(&g_location->npcs[g_location->active_npcs[i]],
+               &saved.npcs[saved.active_npcs[i]],
+               sizeof(npc_t))) {
+      return "an NPC differs";
+    }
+  }
+
+  return NULL;
+}
+
+/*******************************************************************************
+   Function: test_format_mismatch
+
+Description: Saves a location, marks it as saved with other map dimensions and
+             checks that it isn't loaded (or allowed to touch the current
+             location).
+
+     Inputs: None.
+
+    Outputs: A description of the first problem found, or NULL if none.
+*******************************************************************************/
+static const char *test_format_mismatch(void) {
+  static location_t current;
+
+  load_random_location();
+  host_clear_persistent_storage();
+  save_location();
+  persist_write_int(STORAGE_FORMAT_KEY,
+                    (STORAGE_FORMAT_VERSION << 16) |
+                      ((MAP_WIDTH + 1) << 8) |
+                      MAP_HEIGHT);
+  load_random_location();
+  current = *g_location;
+  if (load_location()) {
+    return "a location with other map dimensions was loaded";
+  }
+  if (memcmp(g_location, &current, sizeof(location_t))) {
+    return "the refused location changed the current one";
+  }
+
+  return NULL;
+}
+
+/*******************************************************************************
+   Function: test_legacy_location
+
+Description: Writes a location as saved by older versions (a byte per cell of a
+             10x10 map, with two NPCs), loads it, then saves it again.
+
+     Inputs: None.
+
+    Outputs: A description of the first problem found, or NULL if none.
+*******************************************************************************/
+static const char *test_legacy_location(void) {
+  int8_t i, j;
+  legacy_location_t legacy_location;
+  const char *problem;
+
+  memset(&legacy_location, 0, sizeof(legacy_location));
+  for (i = 0; i < LEGACY_MAP_WIDTH; ++i) {
+    for (j = 0; j < LEGACY_MAP_WIDTH; ++j) {
+      legacy_location.map[i][j] = rand() % 2 ? SOLID :
+                                  rand() % 8 ? EMPTY :
+                                               RANDOM_ITEM;
+    }
+  }
+  legacy_location.map[LEGACY_MAP_WIDTH - 1][0] = EXIT;
+
+  // The expected map, converted cell by cell as "load_location" does:
+  reset_map();
+  for (i = 0; i < LEGACY_MAP_WIDTH && i < MAP_WIDTH; ++i) {
+    for (j = 0; j < LEGACY_MAP_WIDTH && j < MAP_HEIGHT; ++j) {
+      edit_cell(GPoint(i, j), legacy_location.map[i][j]);
+    }
+  }
+  legacy_location.entrance = GPoint(0, LEGACY_MAP_WIDTH - 1);
+  for (i = 0; i < LEGACY_MAX_NPCS_AT_ONE_TIME; ++i) {
+    legacy_location.npcs[i].position = GPoint(i, i);
+    legacy_location.npcs[i].type = i;
+    legacy_location.npcs[i].health = 10 + i;
+    legacy_location.npcs[i].status_effects[0] = 3 + i;
+  }
+  host_clear_persistent_storage();
+  persist_write_data(LEGACY_LOCATION_STORAGE_KEY,
+                     &legacy_location,
+                     sizeof(legacy_location));
+  if (!load_location()) {
+    return "the older version's location wasn't loaded";
+  }
+  if ((problem = check_map())) {
+    return problem;
+  }
+  if (g_location->num_active_npcs != LEGACY_MAX_NPCS_AT_ONE_TIME ||
+      g_location->npcs[g_location->active_npcs[1]].health != 11 ||
+      g_location->npcs[g_location->active_npcs[1]].
+        status_effect_expiry_ticks[0] != 4) {
+    return "the older version's NPCs weren't converted";
+  }
+  save_location();
+  if (persist_exists(LEGACY_LOCATION_STORAGE_KEY) ||
+      persist_read_int(STORAGE_FORMAT_KEY) != STORAGE_FORMAT) {
+    return "the older version's save wasn't replaced";
+  }
+
+  return NULL;
+}
+
+/*******************************************************************************
+   Function: test_storage_budget
+
+Description: Saves the player and the largest possible location (every table
+             entry and NPC slot in use), then fills storage and checks that a
+             save that no longer fits fails.
+
+     Inputs: None.
+
+    Outputs: A description of the first problem found, or NULL if none.
+*******************************************************************************/
+static const char *test_storage_budget(void) {
+  int16_t i;
+  uint32_t key;
+  const uint32_t bytes_written = g_host_counters.persist_bytes_written;
+  uint8_t filler[PERSIST_DATA_MAX_LENGTH] = {0};
+  const char *problem;
+
+  reset_map();
+  for (i = 0; i < MAP_WIDTH * MAP_HEIGHT - 1; ++i) {
+    edit_cell(GPoint(i % MAP_WIDTH, i / MAP_WIDTH), SHIELD);
+  }
+  edit_cell(GPoint(MAP_WIDTH - 1, MAP_HEIGHT - 1), EXIT);
+  for (i = 0; i < MAX_NPCS_AT_ONE_TIME; ++i) {
+    add_new_npc(i % NUM_NPC_TYPES, GPoint(i % MAP_WIDTH, i / MAP_WIDTH));
+  }
+  if (g_location->num_special_cells != MAX_SPECIAL_CELLS ||
+      g_location->num_active_npcs != MAX_NPCS_AT_ONE_TIME) {
+    return "the location isn't full";
+  }
+  host_clear_persistent_storage();
+  if (persist_write_data(PLAYER_STORAGE_KEY,
+                         g_player,
+                         sizeof(player_t)) < 0 ||
+      !save_location()) {
+    return "the largest location didn't fit alongside the player";
+  }
+  printf("largest %dx%d save: %lu of %d bytes\n",
+         MAP_WIDTH,
+         MAP_HEIGHT,
+         (unsigned long) (g_host_counters.persist_bytes_written -
+                            bytes_written),
+         HOST_PERSIST_STORAGE_SIZE);
+  host_clear_persistent_storage();
+  for (key = 1; persist_write_data(key, filler, sizeof(filler)) >= 0; ++key) {}
+  persist_delete(1);
+  problem = save_location() ? "a save that didn't fit succeeded" : NULL;
+  host_clear_persistent_storage();
+
+  return problem;
+}
+
+/*******************************************************************************
+   Function: find_special_cell_linearly
+
+Description: The linear scan "find_special_cell" replaced.
+
+     Inputs: cell - Coordinates of the cell of interest.
+
+    Outputs: Index value for "g_location->special_cells" (NONE if not found).
+*******************************************************************************/
+static int16_t find_special_cell_linearly(const GPoint cell) {
+  int16_t i;
+
+  for (i = 0; i < g_location->num_special_cells; ++i) {
+    if (g_location->special_cells[i].x == cell.x &&
+        g_location->special_cells[i].y == cell.y) {
+      return i;
+    }
+  }
+
+  return NONE;
+}
+
+/*******************************************************************************
+   Function: benchmark
+
+Description: Fills the side table with loot, then times lookups of every cell
+             by binary search and by linear scan.
+
+     Inputs: None.
+
+    Outputs: None.
+*******************************************************************************/
+static void benchmark(void) {
+  int16_t i, j, sum = 0;
+  uint64_t binary_time, linear_time;
+
+  reset_map();
+  for (i = 0; i < MAP_WIDTH * MAP_HEIGHT; ++i) {
+    edit_cell(GPoint(rand() % MAP_WIDTH, rand() % MAP_HEIGHT), SHIELD);
+  }
+  binary_time = get_time_in_ns();
+  for (i = 0; i < BENCHMARK_REPS; ++i) {
+    for (j = 0; j < MAP_WIDTH * MAP_HEIGHT; ++j) {
+      sum += find_special_cell(g_location,
+                               GPoint(j % MAP_WIDTH, j / MAP_WIDTH));
+    }
+  }
+  binary_time = get_time_in_ns() - binary_time;
+  linear_time = get_time_in_ns();
+  for (i = 0; i < BENCHMARK_REPS; ++i) {
+    for (j = 0; j < MAP_WIDTH * MAP_HEIGHT; ++j) {
+      sum -= find_special_cell_linearly(GPoint(j % MAP_WIDTH, j / MAP_WIDTH));
+    }
+  }
+  linear_time = get_time_in_ns() - linear_time;
+  printf("lookups in a %d-entry table: binary search %.1f ns, linear scan "
+         "%.1f ns%s\n",
+         g_location->num_special_cells,
+         (double) binary_time / BENCHMARK_REPS / (MAP_WIDTH * MAP_HEIGHT),
+         (double) linear_time / BENCHMARK_REPS / (MAP_WIDTH * MAP_HEIGHT),
+         sum ? " (results differ!)" : "");
+}
+
+/*******************************************************************************
+   Function: main
+
+Description: Runs the checks, then (with "bench") the benchmark.
+
+     Inputs: argc - Number of command-line arguments.
+             argv - Command-line arguments (see the file description).
+
+    Outputs: Zero if every check passes.
+*******************************************************************************/
+int main(int argc, char **argv) {
+  int num_failures = 0;
+  const bool bench = argc > 1 && !strcmp(argv[1], "bench");
+
+  init();
+  srand(argc > 1 + bench ? atoi(argv[1 + bench]) : 1);
+  num_failures += report("full table", test_full_table());
+  num_failures += report("random edits", test_random_edits());
+  num_failures += report("save and load", test_round_trip());
+  num_failures += report("other map dimensions", test_format_mismatch());
+  num_failures += report("older version's save", test_legacy_location());
+  num_failures += report("storage budget", test_storage_budget());
+  if (bench) {
+    benchmark();
+  }
+  deinit();
+  printf("%s\n", num_failures ? "FAILED" : "passed");
+
+  return num_failures ? 1 : 0;
+}